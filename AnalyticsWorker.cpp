@@ -0,0 +1,66 @@
+#include "AnalyticsWorker.h"
+
+/**
+ * AnalyticsWorker:
+ *   Jobs are type-erased tasks in a TaskGroup on the shared TaskScheduler, so they
+ *   share its workers with ingest and matching instead of keeping threads of their own.
+ *   Superseding is a per-channel generation counter: a task remembers the generation it
+ *   was submitted with and checks it before running and again before publishing, so
+ *   cancelling costs one atomic increment and never waits for a running job.
+ */
+
+AnalyticsWorker::AnalyticsWorker(TaskScheduler& _scheduler)
+: scheduler(_scheduler),
+  jobs(_scheduler)
+{
+}
+
+/**
+ * Destructor
+ * Marks every channel superseded so queued tasks resolve to std::nullopt without
+ * running, and waits until every task has finished (helping run them meanwhile).
+ */
+AnalyticsWorker::~AnalyticsWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [name, generation] : channels) {
+            generation->fetch_add(1);
+        }
+    }
+    jobs.wait();
+}
+
+void AnalyticsWorker::cancel(const std::string& channel)
+{
+    channelGeneration(channel)->fetch_add(1);
+}
+
+size_t AnalyticsWorker::pending() const
+{
+    return waiting.load();
+}
+
+/**
+ * channelGeneration
+ * The counter for `channel`, created at 0 on first use. Tasks keep a reference to it,
+ * so it outlives the map entry if need be.
+ */
+AnalyticsWorker::Generation AnalyticsWorker::channelGeneration(const std::string& channel)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& generation = channels[channel];
+    if (!generation) {
+        generation = std::make_shared<std::atomic<std::uint64_t>>(0);
+    }
+    return generation;
+}
+
+void AnalyticsWorker::enqueue(std::function<void()> task)
+{
+    waiting.fetch_add(1);
+    jobs.run([this, task = std::move(task)] {
+        waiting.fetch_sub(1);
+        task();
+    });
+}
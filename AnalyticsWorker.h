@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include "TaskScheduler.h"
+
+/**
+ * AnalyticsWorker: background chart and statistics queries on the TaskScheduler.
+ *   - submit(channel, job) runs `job` as a scheduler task and returns a future of its
+ *     result, so the caller (the menu loop) can go on and collect it when it is ready
+ *   - every job belongs to a channel, e.g. "candles"; submitting to a channel supersedes
+ *     the job already there: if it has not started it is skipped, if it is running its
+ *     result is dropped, and its future holds std::nullopt
+ *   - an exception thrown by a job is rethrown by the future's get()
+ * Jobs that read shared data (the OrderBook) must do their own locking.
+ */
+class AnalyticsWorker
+{
+    public:
+    /** Run jobs on `scheduler` (by default the process-wide one). */
+        explicit AnalyticsWorker(TaskScheduler& scheduler = TaskScheduler::shared());
+    /** Skips jobs that have not started and waits for running ones. */
+        ~AnalyticsWorker();
+        AnalyticsWorker(const AnalyticsWorker&) = delete;
+        AnalyticsWorker& operator=(const AnalyticsWorker&) = delete;
+
+        template <class Job>
+        using Result = std::optional<std::invoke_result_t<Job&>>;
+
+    /** Queue `job` on `channel`, superseding the channel's previous job. */
+        template <class Job>
+        std::future<Result<Job>> submit(const std::string& channel, Job job);
+    /** Supersede the channel's job without queueing a new one. */
+        void cancel(const std::string& channel);
+    /** Number of threads jobs may run on (the scheduler's workers). */
+        size_t threadCount() const { return scheduler.workerCount(); }
+    /** Jobs queued but not yet started (including superseded ones not yet skipped). */
+        size_t pending() const;
+
+    private:
+        using Generation = std::shared_ptr<std::atomic<std::uint64_t>>;
+
+        Generation channelGeneration(const std::string& channel);
+        void enqueue(std::function<void()> task);
+
+        TaskScheduler& scheduler;
+        std::unordered_map<std::string, Generation> channels;
+        mutable std::mutex mutex;
+        std::atomic<size_t> waiting{0};   // queued jobs not yet started
+        TaskGroup jobs;                   // every job submitted; waited for on destruction
+};
+
+template <class Job>
+std::future<AnalyticsWorker::Result<Job>> AnalyticsWorker::submit(const std::string& channel, Job job)
+{
+    Generation generation = channelGeneration(channel);
+    const std::uint64_t mine = generation->fetch_add(1) + 1;
+
+    auto promise = std::make_shared<std::promise<Result<Job>>>();
+    auto future = promise->get_future();
+    enqueue([generation, mine, promise, job = std::move(job)]() mutable {
+        // Superseded before a worker got to it: don't run it at all
+        if (generation->load() != mine) {
+            promise->set_value(std::nullopt);
+            return;
+        }
+        try {
+            auto value = job();
+            // Superseded while running: the newer job's result is the one that counts
+            if (generation->load() != mine) {
+                promise->set_value(std::nullopt);
+            } else {
+                promise->set_value(std::move(value));
+            }
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
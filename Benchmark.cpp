@@ -0,0 +1,242 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    /** Process CPU time in seconds (all threads). */
+    double cpuNow()
+    {
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+    }
+
+    /** Escape a string for a JSON string literal. */
+    std::string jsonString(const std::string& s)
+    {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof buf, "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+}
+
+BenchmarkState::BenchmarkState(size_t iterations)
+: maxIterations(iterations)
+{
+}
+
+/**
+ * keepRunning
+ * Starts the clocks on the first call and stops them once `maxIterations` have been
+ * done, so only the loop body is timed.
+ */
+bool BenchmarkState::keepRunning()
+{
+    if (done == 0 && !running) {
+        startClocks();
+    }
+    if (done < maxIterations && skipped.empty()) {
+        ++done;
+        return true;
+    }
+    if (running) {
+        stopClocks();
+    }
+    return false;
+}
+
+void BenchmarkState::pauseTiming()
+{
+    if (running) {
+        stopClocks();
+    }
+}
+
+void BenchmarkState::resumeTiming()
+{
+    if (!running) {
+        startClocks();
+    }
+}
+
+void BenchmarkState::setItemsProcessed(size_t n)
+{
+    items = n;
+}
+
+void BenchmarkState::setBytesProcessed(size_t n)
+{
+    bytes = n;
+}
+
+void BenchmarkState::setCounter(const std::string& name, double value)
+{
+    counters[name] = value;
+}
+
+void BenchmarkState::skip(const std::string& message)
+{
+    skipped = message;
+}
+
+void BenchmarkState::startClocks()
+{
+    running = true;
+    realStart = Clock::now();
+    cpuStart = cpuNow();
+}
+
+void BenchmarkState::stopClocks()
+{
+    running = false;
+    realSeconds += std::chrono::duration<double>(Clock::now() - realStart).count();
+    cpuSeconds += cpuNow() - cpuStart;
+}
+
+void BenchmarkRegistry::add(const std::string& name, Function fn)
+{
+    benchmarks.emplace_back(name, std::move(fn));
+}
+
+/**
+ * run
+ * Behavior:
+ *   - Runs each selected benchmark with 1 iteration, then keeps scaling the count by
+ *     the ratio needed to reach `minSeconds` (at most 10x per round, capped at 1e9)
+ *     until a run is long enough; only that last run is reported.
+ *   - A benchmark that calls skip() is reported once with its message.
+ */
+const std::vector<BenchmarkRegistry::Result>&
+BenchmarkRegistry::run(const std::string& filter, double minSeconds, std::ostream& progress)
+{
+    results.clear();
+    for (auto& [name, fn] : benchmarks) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        size_t iterations = 1;
+        for (;;) {
+            BenchmarkState state(iterations);
+            fn(state);
+
+            bool enough = state.realSeconds >= minSeconds || iterations >= 1000000000;
+            if (!state.skipped.empty() || enough) {
+                Result r;
+                r.name = name;
+                r.skipped = state.skipped;
+                r.iterations = state.done;
+                r.counters = state.counters;
+                if (state.done > 0) {
+                    r.realNs = state.realSeconds * 1e9 / static_cast<double>(state.done);
+                    r.cpuNs = state.cpuSeconds * 1e9 / static_cast<double>(state.done);
+                }
+                if (state.realSeconds > 0) {
+                    r.itemsPerSecond = static_cast<double>(state.items) / state.realSeconds;
+                    r.bytesPerSecond = static_cast<double>(state.bytes) / state.realSeconds;
+                }
+                results.push_back(std::move(r));
+                break;
+            }
+
+            double scale = state.realSeconds > 0 ? minSeconds * 1.4 / state.realSeconds : 10.0;
+            scale = std::clamp(scale, 2.0, 10.0);
+            iterations = static_cast<size_t>(static_cast<double>(iterations) * scale);
+        }
+
+        const Result& r = results.back();
+        if (!r.skipped.empty()) {
+            progress << std::left << std::setw(48) << r.name << " SKIPPED: " << r.skipped << "\n";
+        } else {
+            progress << std::left << std::setw(48) << r.name
+                     << std::right << std::setw(14) << std::fixed << std::setprecision(0) << r.realNs << " ns"
+                     << std::setw(14) << r.cpuNs << " ns"
+                     << std::setw(11) << r.iterations;
+            if (r.itemsPerSecond > 0) {
+                progress << "  items/s=" << std::setprecision(3) << std::scientific << r.itemsPerSecond;
+            }
+            if (r.bytesPerSecond > 0) {
+                progress << "  MB/s=" << std::fixed << std::setprecision(1) << r.bytesPerSecond / 1e6;
+            }
+            progress << std::defaultfloat << "\n";
+        }
+        progress.flush();
+    }
+    return results;
+}
+
+/**
+ * writeJson
+ * Writes {"context": {...}, "benchmarks": [...]}, with times in ns and the fields
+ * Google Benchmark uses (name, run_type, iterations, real_time, cpu_time, time_unit,
+ * items_per_second, bytes_per_second, plus counters and error_message for skips).
+ */
+void BenchmarkRegistry::writeJson(std::ostream& out) const
+{
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": " << jsonString(date) << ",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+        << "    \"library_build_type\": \"release\"\n"
+#else
+        << "    \"library_build_type\": \"debug\"\n"
+#endif
+        << "  },\n  \"benchmarks\": [";
+
+    std::ostringstream num;
+    num << std::setprecision(10);
+    const char* sep = "\n";
+    for (const Result& r : results) {
+        out << sep << "    {\n"
+            << "      \"name\": " << jsonString(r.name) << ",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << r.iterations << ",\n";
+        num.str("");
+        num << r.realNs;
+        out << "      \"real_time\": " << num.str() << ",\n";
+        num.str("");
+        num << r.cpuNs;
+        out << "      \"cpu_time\": " << num.str() << ",\n"
+            << "      \"time_unit\": \"ns\"";
+        if (r.itemsPerSecond > 0) {
+            num.str("");
+            num << r.itemsPerSecond;
+            out << ",\n      \"items_per_second\": " << num.str();
+        }
+        if (r.bytesPerSecond > 0) {
+            num.str("");
+            num << r.bytesPerSecond;
+            out << ",\n      \"bytes_per_second\": " << num.str();
+        }
+        for (auto const& [key, value] : r.counters) {
+            num.str("");
+            num << value;
+            out << ",\n      " << jsonString(key) << ": " << num.str();
+        }
+        if (!r.skipped.empty()) {
+            out << ",\n      \"error_occurred\": true"
+                << ",\n      \"error_message\": " << jsonString(r.skipped);
+        }
+        out << "\n    }";
+        sep = ",\n";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * A small benchmark harness in the style of Google Benchmark, so the engine can be timed
+ * without an extra dependency.
+ *   - BenchmarkRegistry::add(name, fn) registers a benchmark; fn loops on state.keepRunning()
+ *   - run() calibrates each benchmark's iteration count to a minimum run time and records
+ *     real and CPU time per iteration, plus items/bytes per second and custom counters
+ *   - writeJson() emits the same "context"/"benchmarks" layout as --benchmark_format=json,
+ *     so results can be compared with the usual tooling
+ */
+class BenchmarkState
+{
+    public:
+        explicit BenchmarkState(size_t iterations);
+
+    /** Loop condition: true `iterations` times, timing from the first call to the last. */
+        bool keepRunning();
+    /** Stop the clocks around per-iteration setup that should not be measured. */
+        void pauseTiming();
+        void resumeTiming();
+
+    /** Total items / bytes handled across all iterations (reported per second). */
+        void setItemsProcessed(size_t items);
+        void setBytesProcessed(size_t bytes);
+    /** Extra value reported as-is (e.g. rows, result sizes). */
+        void setCounter(const std::string& name, double value);
+    /** Mark the benchmark skipped (e.g. input missing); it is reported with this message. */
+        void skip(const std::string& message);
+
+        size_t iterations() const { return maxIterations; }
+
+    private:
+        friend class BenchmarkRegistry;
+        using Clock = std::chrono::steady_clock;
+
+        void startClocks();
+        void stopClocks();
+
+        size_t maxIterations;
+        size_t done = 0;
+        bool running = false;
+        Clock::time_point realStart;
+        double cpuStart = 0.0;
+        double realSeconds = 0.0;
+        double cpuSeconds = 0.0;
+        size_t items = 0;
+        size_t bytes = 0;
+        std::map<std::string, double> counters;
+        std::string skipped;
+};
+
+/** Keep the compiler from optimising away a value computed only for timing. */
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+class BenchmarkRegistry
+{
+    public:
+        using Function = std::function<void(BenchmarkState&)>;
+
+    /** One finished benchmark, times in nanoseconds per iteration. */
+        struct Result
+        {
+            std::string name;
+            size_t iterations = 0;
+            double realNs = 0.0;
+            double cpuNs = 0.0;
+            double itemsPerSecond = 0.0;
+            double bytesPerSecond = 0.0;
+            std::map<std::string, double> counters;
+            std::string skipped;
+        };
+
+    /** Register a benchmark; they run in registration order. */
+        void add(const std::string& name, Function fn);
+    /**
+    * Run every benchmark whose name contains `filter` (all if empty). Each is first run
+    * once, then with growing iteration counts until one run lasts `minSeconds`.
+    * Progress lines go to `progress` as each benchmark finishes.
+    */
+        const std::vector<Result>& run(const std::string& filter, double minSeconds,
+                                       std::ostream& progress);
+    /** Results in Google Benchmark's JSON layout. */
+        void writeJson(std::ostream& out) const;
+
+    private:
+        std::vector<std::pair<std::string, Function>> benchmarks;
+        std::vector<Result> results;
+};
@@ -1,10 +1,17 @@
 #include "CSVReader.h"
+#include "Metrics.h"
+#include "Logger.h"
+#include "TaskScheduler.h"
 #include <algorithm>
 #include <set>
 #include <vector>
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <filesystem>
+#include <charconv>
+#include <stdexcept>
 
 /**
  * CSVReader:
@@ -23,52 +30,146 @@ CSVReader::CSVReader()
     // No state to initialize; methods below operate purely on inputs.
 }
 
+/**
+ * parseDouble
+ * Converts a numeric field to double without copying it into a std::string.
+ * Accepts what std::stod accepts for our data: optional leading whitespace and sign,
+ * then a number; anything after the number is ignored.
+ *
+ * @throws std::invalid_argument if no number can be read,
+ *         std::out_of_range if it does not fit in a double (same as std::stod).
+ */
+static double parseDouble(std::string_view field)
+{
+    size_t start = field.find_first_not_of(" \t");
+    if (start == std::string_view::npos) {
+        throw std::invalid_argument{"parseDouble: empty field"};
+    }
+    field.remove_prefix(start);
+    if (field.front() == '+') {
+        field.remove_prefix(1);   // from_chars does not accept an explicit '+'
+    }
+
+    double value = 0.0;
+    auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (ec == std::errc::invalid_argument) {
+        throw std::invalid_argument{"parseDouble: not a number"};
+    }
+    if (ec == std::errc::result_out_of_range) {
+        throw std::out_of_range{"parseDouble: out of range"};
+    }
+    return value;
+}
+
+/**
+ * parseLines
+ * Converts every line of `text` into an OrderBookEntry appended to `entries`, splitting
+ * lines the way std::getline does: at '\n', with no empty line after a final '\n'.
+ * Malformed lines (empty ones included) are logged, counted in `badRows` and skipped.
+ */
+void CSVReader::parseLines(std::string_view text, std::vector<OrderBookEntry>& entries, size_t& badRows)
+{
+    std::vector<std::string_view> tokens;      // Views into `text`, reused for every row
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        try {
+            // 1) Tokenize the line into views of its fields
+            tokenise(text.substr(start, end - start), ',', tokens);
+            // 2) Convert the tokens to an OrderBookEntry, straight into the results
+            entries.push_back(stringsToOBE(tokens));
+        }
+        catch (const std::exception& e) {
+            // Malformed line: skip, but log a warning
+            ++badRows;
+            LOG_WARN("CSVReader::readCSV bad data");
+        }
+        start = end + 1;
+    }
+}
+
 /**
  * readCSV
- * Reads a CSV file of order‐book entries, line by line, and converts each
- * valid line into an OrderBookEntry. If any line is malformed, it is skipped.
+ * Reads a CSV file of order‐book entries and converts each valid line into an
+ * OrderBookEntry. If any line is malformed, it is skipped.
  *
  * @param csvFilename  Path to the CSV file (e.g., "20200317.csv").
- * @return A vector of OrderBookEntry objects parsed from the file.
+ * @return A vector of OrderBookEntry objects parsed from the file, in file order.
  *
  * Behavior:
- *   - Opens the file in ifstream.
- *   - While not at end of file, reads each line as a std::string.
- *   - Tries to tokenize the line on commas and convert tokens into an OrderBookEntry.
- *   - If tokenization or conversion fails (e.g., wrong number of tokens or invalid number),
- *     catches the exception, logs a “bad data” message, and continues to next line.
- *   - At end, prints the total number of successfully read entries and returns them.
+ *   - Reads the whole file into one buffer.
+ *   - Small files are parsed on the calling thread with parseLines.
+ *   - Larger files are cut into one block per scheduler worker, each ending just after
+ *     a newline, and the blocks are parsed as TaskScheduler tasks into separate
+ *     vectors, which are then concatenated in block order.
+ *   - Tokenizing works on views into the buffer (no per-field copies); a line that
+ *     fails to tokenize or convert is logged as “bad data” and skipped.
+ *   - At end, logs the total number of successfully read entries and returns them.
  */
-std::vector<OrderBookEntry> CSVReader::readCSV(std::string csvFilename)
+std::vector<OrderBookEntry> CSVReader::readCSV(const std::string& csvFilename)
 {
+    MERKEL_TIMED_SCOPE("CSVReader::readCSV");
+    const size_t MIN_BLOCK = 1 << 20;          // below this, a task costs more than it saves
     std::vector<OrderBookEntry> entries;       // Will hold all successfully parsed entries
+    size_t badRows = 0;
 
-    std::ifstream csvFile{csvFilename};        // Attempt to open the CSV
-    std::string line;
+    std::ifstream csvFile{csvFilename, std::ios::binary};   // Attempt to open the CSV
+    if (!csvFile.is_open()) {
+        // If the file did not open, log an error.
+        LOG_ERROR("CSVReader::readCSV could not open file: " << csvFilename);
+        LOG_INFO("CSVReader::readCSV read 0 entries");
+        return entries;
+    }
+    std::string text{std::istreambuf_iterator<char>(csvFile), std::istreambuf_iterator<char>()};
 
-    if (csvFile.is_open()) {
-        // Read each line until EOF
-        while (std::getline(csvFile, line)) {
-            try {
-                // 1) Tokenize the line into a vector<string>
-                std::vector<std::string> tokens = tokenise(line, ',');
-                // 2) Convert the tokens to an OrderBookEntry
-                OrderBookEntry obe = stringsToOBE(tokens);
-                // 3) Add to the results
-                entries.push_back(obe);
-            }
-            catch (const std::exception& e) {
-                // Malformed line: skip, but print a warning
-                std::cout << "CSVReader::readCSV bad data\n";
+    size_t blocks = std::min(TaskScheduler::shared().workerCount(),
+                             std::max<size_t>(1, text.size() / MIN_BLOCK));
+    if (blocks == 1) {
+        parseLines(text, entries, badRows);
+    } else {
+        // 1) Cut the buffer into blocks of whole lines
+        std::vector<std::string_view> parts;
+        size_t start = 0;
+        for (size_t b = 1; b <= blocks && start < text.size(); ++b) {
+            size_t end = text.size();
+            if (b < blocks) {
+                end = text.find('\n', std::max(start, text.size() * b / blocks));
+                end = (end == std::string::npos) ? text.size() : end + 1;
             }
+            parts.emplace_back(text.data() + start, end - start);
+            start = end;
+        }
+
+        // 2) Parse the blocks concurrently
+        std::vector<std::vector<OrderBookEntry>> parsed(parts.size());
+        std::vector<size_t> bad(parts.size(), 0);
+        TaskGroup group;
+        for (size_t i = 0; i < parts.size(); ++i) {
+            group.run([&, i] { parseLines(parts[i], parsed[i], bad[i]); });
+        }
+        group.wait();
+
+        // 3) Concatenate in file order
+        size_t total = 0;
+        for (const auto& p : parsed) {
+            total += p.size();
+        }
+        entries.reserve(total);
+        for (size_t i = 0; i < parsed.size(); ++i) {
+            entries.insert(entries.end(), std::make_move_iterator(parsed[i].begin()),
+                                          std::make_move_iterator(parsed[i].end()));
+            badRows += bad[i];
         }
-    } else {
-        // If the file did not open, you could print an error here.
-        std::cout << "CSVReader::readCSV could not open file: " << csvFilename << "\n";
     }
 
     // After reading all lines, log how many entries were parsed
-    std::cout << "CSVReader::readCSV read " << entries.size() << " entries\n";
+    LOG_INFO("CSVReader::readCSV read " << entries.size() << " entries");
+    MERKEL_COUNT("csv.bytes", text.size());
+    MERKEL_COUNT("csv.rows", entries.size());
+    MERKEL_COUNT("csv.badRows", badRows);
     return entries;
 }
 
@@ -76,88 +177,100 @@ std::vector<OrderBookEntry> CSVReader::readCSV(std::string csvFilename)
  * tokenise
  * Splits a single CSV line into individual fields based on a given separator.
  *
- * @param csvLine    The raw line string from the CSV (e.g., "2020/03/17 12:00:00,ETH/USDT,ask,200,0.5")
+ * @param csvLine    The raw line from the CSV (e.g., "2020/03/17 12:00:00,ETH/USDT,ask,200,0.5")
  * @param separator  The character to split on (normally ',' for CSV).
  * @return A vector of strings, each representing one field. If the line is empty
  *         or consists only of separators, returns an empty vector.
  *
  * Behavior:
+ *   - Splits with the view-based overload below, then copies each field into a string.
+ */
+std::vector<std::string> CSVReader::tokenise(std::string_view csvLine, char separator)
+{
+    std::vector<std::string_view> views;
+    tokenise(csvLine, separator, views);
+    return std::vector<std::string>(views.begin(), views.end());
+}
+
+/**
+ * tokenise (view overload)
+ * Splits a single CSV line into views of its fields, without copying any characters.
+ *
+ * @param csvLine    The raw line; it must outlive the views placed in `tokens`.
+ * @param separator  The character to split on (normally ',' for CSV).
+ * @param tokens     Output; cleared first, then filled with one view per field.
+ *                   Reusing the same vector across lines avoids reallocating it.
+ *
+ * Behavior:
  *   - Finds the first non‐separator character as `start`.
  *   - Repeatedly finds the next separator position as `end`.
- *   - Extracts the substring between `start` and `end - 1`.
- *   - Pushes that substring into `tokens`.
+ *   - Adds the view [start, end) to `tokens` (or [start, line end) for the last field).
  *   - Advances `start = end + 1` and repeats until no more fields remain.
- *   - Stops if `start` is at or beyond the line length, or if `start == end`.
+ *   - Stops if `start` is at or beyond the line length, or at an empty field (start == end).
  */
-std::vector<std::string> CSVReader::tokenise(std::string csvLine, char separator)
+void CSVReader::tokenise(std::string_view csvLine, char separator, std::vector<std::string_view>& tokens)
 {
-    std::vector<std::string> tokens;
-    signed int start, end;
-    std::string token;
+    tokens.clear();
 
     // Find first character that is not the separator
-    start = csvLine.find_first_not_of(separator, 0);
+    size_t start = csvLine.find_first_not_of(separator);
 
-    do {
+    while (start != std::string_view::npos && start < csvLine.size()) {
         // Find next occurrence of separator
-        end = csvLine.find_first_of(separator, start);
-        // If start is past the end of the string, or start == end (empty token), break
-        if (start == static_cast<int>(csvLine.length()) || start == end) {
+        size_t end = csvLine.find(separator, start);
+        // Empty token: stop
+        if (end == start) {
             break;
         }
-        // If we found a separator at index `end`, extract substring [start .. end-1]
-        if (end >= 0) {
-            token = csvLine.substr(start, end - start);
-        }
-        // If no more separators (end == npos), extract from start to end of string
-        else {
-            token = csvLine.substr(start, csvLine.length() - start);
+        // If no more separators, the rest of the line is the last token
+        if (end == std::string_view::npos) {
+            tokens.push_back(csvLine.substr(start));
+            break;
         }
-        tokens.push_back(token);
+        tokens.push_back(csvLine.substr(start, end - start));
         // Advance start to character after this separator
         start = end + 1;
-    } while (end > 0);
-
-    return tokens;
+    }
 }
 
 /**
  * stringsToOBE (overload #1)
- * Converts a vector of 5 tokens (strings) into an OrderBookEntry object:
- *   tokens[0] = timestamp (string)
- *   tokens[1] = product   (string, e.g., "ETH/USDT")
- *   tokens[2] = side      (string, either "ask" or "bid")
- *   tokens[3] = price     (string representing a double)
- *   tokens[4] = amount    (string representing a double)
+ * Converts a vector of 5 tokens into an OrderBookEntry object:
+ *   tokens[0] = timestamp
+ *   tokens[1] = product   (e.g., "ETH/USDT")
+ *   tokens[2] = side      (either "ask" or "bid")
+ *   tokens[3] = price     (text of a double)
+ *   tokens[4] = amount    (text of a double)
  *
- * @param tokens  A vector<string> of length exactly 5.
+ * @param tokens  A vector of views, of length exactly 5.
  * @return An OrderBookEntry constructed from these tokens.
  *
  * Behavior:
  *   - If tokens.size() != 5, prints "Bad line" and throws an exception.
- *   - Attempts to convert price and amount tokens to doubles using std::stod.
+ *   - Converts price and amount tokens to doubles (parseDouble, no string copies).
  *   - If conversion fails, prints a “Bad float!” message for each offending token and rethrows.
  *   - Uses OrderBookEntry::stringToOrderBookType(tokens[2]) to convert "ask"/"bid" to enum.
- *   - Returns a new OrderBookEntry with (price, amount, timestamp, product, orderType).
+ *   - Returns a new OrderBookEntry with (price, amount, timestamp, product, orderType);
+ *     its constructor interns the timestamp/product views, so nothing is copied per row.
  */
-OrderBookEntry CSVReader::stringsToOBE(std::vector<std::string> tokens)
+OrderBookEntry CSVReader::stringsToOBE(const std::vector<std::string_view>& tokens)
 {
     double price, amount;
 
     // Ensure exactly 5 tokens
     if (tokens.size() != 5) {
-        std::cout << "Bad line\n";
+        LOG_WARN("Bad line");
         throw std::exception{};
     }
     // Convert tokens[3] and tokens[4] to doubles
     try {
-        price  = std::stod(tokens[3]);
-        amount = std::stod(tokens[4]);
+        price  = parseDouble(tokens[3]);
+        amount = parseDouble(tokens[4]);
     }
     catch (const std::exception& e) {
         // If conversion fails, log which fields could not be parsed
-        std::cout << "CSVReader::stringsToOBE Bad float! " << tokens[3] << "\n";
-        std::cout << "CSVReader::stringsToOBE Bad float! " << tokens[4] << "\n";
+        LOG_WARN("CSVReader::stringsToOBE Bad float! " << tokens[3]);
+        LOG_WARN("CSVReader::stringsToOBE Bad float! " << tokens[4]);
         throw;  // Propagate exception to caller
     }
 
@@ -167,102 +280,229 @@ OrderBookEntry CSVReader::stringsToOBE(std::vector<std::string> tokens)
     //   - timestamp  = tokens[0]
     //   - product    = tokens[1]
     //   - orderType  = enum converted from tokens[2]
-    OrderBookEntry obe{
+    return OrderBookEntry{
         price,
         amount,
         tokens[0],                                      // timestamp
         tokens[1],                                      // product
         OrderBookEntry::stringToOrderBookType(tokens[2]) // convert "ask"/"bid"
     };
-
-    return obe;
 }
 
 /**
  * stringsToOBE (overload #2)
  * Converts individual string fields into an OrderBookEntry:
- *   priceString  = string representing a double (e.g., "200.5")
- *   amountString = string representing a double (e.g., "0.75")
- *   timestamp    = full timestamp string (e.g., "2020/06/01 12:00:00.000000")
+ *   priceString  = text of a double (e.g., "200.5")
+ *   amountString = text of a double (e.g., "0.75")
+ *   timestamp    = full timestamp (e.g., "2020/06/01 12:00:00.000000")
  *   product      = currency pair (e.g., "ETH/USDT")
  *   orderType    = OrderBookType enum (ask or bid)
  *
- * @param priceString   Price as string
- * @param amountString  Amount as string
- * @param timestamp     Timestamp as string
- * @param product       Product as string
+ * @param priceString   Price as text
+ * @param amountString  Amount as text
+ * @param timestamp     Timestamp as text
+ * @param product       Product as text
  * @param orderType     Already‐parsed enum for ask/bid
  * @return A new OrderBookEntry constructed from these fields.
  *
  * Behavior:
- *   - Attempts to convert priceString and amountString to double using std::stod.
+ *   - Takes every field as a string_view, so callers holding std::strings pass them
+ *     without copies.
+ *   - Converts priceString and amountString to double with parseDouble.
  *   - If conversion fails, prints a “Bad float!” message and rethrows.
  *   - Constructs and returns an OrderBookEntry with (price, amount, timestamp, product, orderType).
  */
 OrderBookEntry CSVReader::stringsToOBE(
-    std::string priceString,
-    std::string amountString,
-    std::string timestamp,
-    std::string product,
+    std::string_view priceString,
+    std::string_view amountString,
+    std::string_view timestamp,
+    std::string_view product,
     OrderBookType orderType)
 {
     double price, amount;
     try {
-        price  = std::stod(priceString);
-        amount = std::stod(amountString);
+        price  = parseDouble(priceString);
+        amount = parseDouble(amountString);
     }
     catch (const std::exception& e) {
-        std::cout << "CSVReader::stringsToOBE Bad float! " << priceString << "\n";
-        std::cout << "CSVReader::stringsToOBE Bad float! " << amountString << "\n";
+        LOG_WARN("CSVReader::stringsToOBE Bad float! " << priceString);
+        LOG_WARN("CSVReader::stringsToOBE Bad float! " << amountString);
         throw;  // Propagate to caller
     }
     // Construct and return the OrderBookEntry
-    OrderBookEntry obe{
+    return OrderBookEntry{
         price,
         amount,
         timestamp,
         product,
         orderType
     };
-    return obe;
 }
 
 /**
  * getAllTimestamps
- * Gathers every unique timestamp (string) from a predefined list of CSV files,
- * then returns them as a sorted vector. Used to build candlestick data over time.
+ * Gathers every unique timestamp (string) from the given CSV files,
+ * then returns them as a sorted vector.
  *
+ * @param files  Paths of the CSV files to scan.
  * @return A sorted std::vector<std::string> containing every distinct timestamp
  *         found in all listed CSV files.
  *
  * Behavior:
- *   - Defines a hardcoded list of CSV file names (e.g., "20200317.csv", "20200601.csv").
  *   - For each filename:
  *       • Calls readCSV(filename) to load all OrderBookEntry objects.
  *       • Inserts each entry.timestamp into a std::set<std::string> to ensure uniqueness.
  *   - After processing all files, converts the set (automatically sorted) into a vector and returns it.
  *
  * Note:
- *   - This method assumes those CSV files are located in the working directory.
- *   - If you add more CSV files, you must update the `files` vector accordingly.
+ *   - OrderBook::getAllTimestamps answers the same question for data that is already
+ *     loaded, without touching the files again; analytics use that one.
  */
-std::vector<std::string> CSVReader::getAllTimestamps() {
+std::vector<std::string> CSVReader::getAllTimestamps(const std::vector<std::string>& files) {
     std::set<std::string> uniq;  // Will store unique timestamps in sorted order
 
-    // List all CSV files from which to collect timestamps
-    const std::vector<std::string> files = {
-        "20200317.csv",
-        "20200601.csv"
-    };
-
     // For each CSV file, read all entries and insert each timestamp into the set
     for (auto& filename : files) {
         std::vector<OrderBookEntry> entries = CSVReader().readCSV(filename);
         for (auto& e : entries) {
-            uniq.insert(e.timestamp);
+            uniq.insert(std::string(e.timestamp));
         }
     }
 
     // Convert the set into a sorted vector and return
     return std::vector<std::string>(uniq.begin(), uniq.end());
 }
+
+/**
+ * readTimeRange
+ * Finds the earliest and latest timestamps of the valid rows of a CSV file without
+ * building any entries. Used to index day files cheaply (OrderBook lazy mode).
+ *
+ * @param csvFilename  Path to the CSV file.
+ * @param first        Receives the earliest timestamp of a valid row.
+ * @param last         Receives the latest timestamp of a valid row.
+ * @return true if a valid row was found, false otherwise (first/last are then empty).
+ *
+ * Behavior:
+ *   - Reads every line into one reused buffer and tokenizes it into reused views.
+ *   - A line is valid when it has 5 fields and its price and amount parse, as in
+ *     stringsToOBE; invalid and blank lines are passed over quietly (the parse logs them).
+ *   - Keeps the minimum and maximum timestamp seen, so the range is right even when the
+ *     file is not in time order. Nothing is interned or allocated per row.
+ */
+bool CSVReader::readTimeRange(const std::string& csvFilename, std::string& first, std::string& last)
+{
+    first.clear();
+    last.clear();
+
+    std::ifstream csvFile{csvFilename, std::ios::binary};
+    if (!csvFile.is_open()) {
+        LOG_ERROR("CSVReader::readTimeRange could not open file: " << csvFilename);
+        return false;
+    }
+
+    std::string line;
+    std::vector<std::string_view> tokens;
+    bool found = false;
+    while (std::getline(csvFile, line)) {
+        std::string_view row{line};
+        if (!row.empty() && row.back() == '\r') {
+            row.remove_suffix(1);
+        }
+        if (row.empty()) {
+            continue;
+        }
+        try {
+            tokenise(row, ',', tokens);
+            if (tokens.size() != 5) {
+                continue;
+            }
+            parseDouble(tokens[3]);
+            parseDouble(tokens[4]);
+        }
+        catch (const std::exception& e) {
+            continue;
+        }
+
+        std::string_view timestamp = tokens[0];
+        if (!found || timestamp < first) {
+            first.assign(timestamp);
+        }
+        if (!found || last < timestamp) {
+            last.assign(timestamp);
+        }
+        found = true;
+    }
+    return found;
+}
+
+/**
+ * wildcardMatch
+ * Returns true if `name` matches `pattern`, where '*' matches any run of characters
+ * (including none) and '?' matches exactly one character.
+ */
+static bool wildcardMatch(const std::string& pattern, const std::string& name)
+{
+    size_t p = 0, n = 0;
+    size_t star = std::string::npos, mark = 0;   // last '*' seen, and where it started matching
+
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            ++p;
+            ++n;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            mark = n;
+        } else if (star != std::string::npos) {
+            // Let the last '*' swallow one more character and retry
+            p = star + 1;
+            n = ++mark;
+        } else {
+            return false;
+        }
+    }
+    // Any trailing '*' can match the empty remainder
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+/**
+ * expandGlob
+ * Lists the files matching a simple glob pattern.
+ *
+ * @param pattern  Either a directory (e.g., "data/"), meaning every "*.csv" in it, or a
+ *                 path whose file-name part may contain '*' / '?' (e.g., "data/202006*.csv").
+ *                 A pattern without wildcards that names a file matches just that file.
+ * @return The matching regular files, sorted by path (daily dumps then come in date order).
+ *
+ * Behavior:
+ *   - Splits the pattern into directory and file-name parts with std::filesystem.
+ *   - Iterates the directory (non-recursively) and keeps regular files whose name matches.
+ *   - A missing directory yields an empty list.
+ */
+std::vector<std::string> CSVReader::expandGlob(const std::string& pattern)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+
+    fs::path dir  = pattern;
+    std::string namePattern = "*.csv";
+    if (!fs::is_directory(dir, ec)) {
+        namePattern = dir.filename().string();
+        dir = dir.parent_path();
+        if (dir.empty()) {
+            dir = ".";
+        }
+    }
+
+    std::vector<std::string> files;
+    for (fs::directory_iterator it{dir, ec}, end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && wildcardMatch(namePattern, it->path().filename().string())) {
+            files.push_back(it->path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
@@ -3,12 +3,14 @@
 #include "OrderBookEntry.h"
 #include <vector>
 #include <string>
+#include <string_view>
 /**
  * CSVReader provides static methods to:
  *   1) Read a CSV file of raw orderbook lines into a vector<OrderBookEntry>
  *   2) Tokenize a single line by comma
  *   3) Convert tokens to an OrderBookEntry
- *   4) Gather all unique timestamps across multiple CSV files (for candlestick/volume loops)
+ *   4) Gather all unique timestamps across multiple CSV files
+ *   5) Expand a file glob / directory into a list of CSV files
  */
 
 class CSVReader
@@ -19,31 +21,43 @@ class CSVReader
         * Read an entire CSV (one order per line) into a vector<OrderBookEntry>.
         * Each line must have exactly 5 tokens: timestamp, product, orderType, price, amount.
         */
-     static std::vector<OrderBookEntry> readCSV(std::string csvFile);
+     static std::vector<OrderBookEntry> readCSV(const std::string& csvFile);
     /**
      * Tokenize a CSV line by `separator` character (usually comma).
      * Returns a vector of tokens (strings).
      */
-     static std::vector<std::string> tokenise(std::string csvLine, char separator);
+     static std::vector<std::string> tokenise(std::string_view csvLine, char separator);
+    /**
+     * Same as above, but fills `tokens` (cleared first) with views into `csvLine`,
+     * so a caller reusing one vector tokenises without allocating.
+     */
+     static void tokenise(std::string_view csvLine, char separator, std::vector<std::string_view>& tokens);
  /**
  * Convert (priceString, amountString, timestamp, product, orderType) into an OrderBookEntry.
  */
-     static OrderBookEntry stringsToOBE(std::string price, 
-                                        std::string amount, 
-                                        std::string timestamp, 
-                                        std::string product, 
+     static OrderBookEntry stringsToOBE(std::string_view price, 
+                                        std::string_view amount, 
+                                        std::string_view timestamp, 
+                                        std::string_view product, 
                                         OrderBookType OrderBookType);
     /**
-        * Return a sorted vector of every unique timestamp seen across all CSV files
-        * listed in this function. We hardcode file names here (for simplicity).
-        */
-    // at the bottom of the public API
+     * Return every unique timestamp across the given CSV files, sorted ascending.
+     */
+    static std::vector<std::string> getAllTimestamps(const std::vector<std::string>& files);
+    /**
+     * Scan a CSV file for the earliest and latest timestamps of its valid rows, in any
+     * row order, without building entries.
+     * Returns false (leaving both empty) if the file has no valid row.
+     */
+    static bool readTimeRange(const std::string& csvFile, std::string& first, std::string& last);
     /**
-     * Return every unique timestamp in the CSV, sorted ascending.
+     * Expand a glob such as "data/2020*.csv" ('*' and '?' in the file-name part) into the
+     * sorted list of matching files. A plain directory expands to every "*.csv" inside it.
      */
-    static std::vector<std::string> getAllTimestamps();
+    static std::vector<std::string> expandGlob(const std::string& pattern);
 
     private:
-     static OrderBookEntry stringsToOBE(std::vector<std::string> strings);
+     static OrderBookEntry stringsToOBE(const std::vector<std::string_view>& strings);
+     static void parseLines(std::string_view text, std::vector<OrderBookEntry>& entries, size_t& badRows);
      
 };
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "ChartViewport.h"
+#include "TextPlotter.h"
+#include <algorithm>
+#include <iostream>
+
+/**
+ * LodPyramid / ChartViewport:
+ *   The pyramid is built once per series (O(n) time, < 2n buckets). After that, a pan or
+ *   zoom touches only the buckets of one level inside the window: about `width` of them,
+ *   however many days the series spans.
+ */
+
+/**
+ * Constructor (candles)
+ * Level 0 keeps each candle's OHLC; sum/samples hold its close so a candle pyramid can
+ * also be read as a line.
+ */
+LodPyramid::LodPyramid(const std::vector<Candlestick>& candles)
+: seriesKind(ChartKind::candles)
+{
+    labels.reserve(candles.size());
+    levels.emplace_back();
+    levels[0].reserve(candles.size());
+    for (size_t i = 0; i < candles.size(); ++i) {
+        const auto& c = candles[i];
+        labels.push_back(c.timestamp);
+        levels[0].push_back(Bucket{i, 1, c.open, c.high, c.low, c.close, c.close, 1});
+    }
+    buildLevels();
+}
+
+/**
+ * Constructor (series)
+ * Level 0 is one flat bucket per point (open = high = low = close = value).
+ */
+LodPyramid::LodPyramid(ChartKind kind, const std::vector<std::pair<std::string, double>>& series)
+: seriesKind(kind)
+{
+    labels.reserve(series.size());
+    levels.emplace_back();
+    levels[0].reserve(series.size());
+    for (size_t i = 0; i < series.size(); ++i) {
+        double v = series[i].second;
+        labels.push_back(series[i].first);
+        levels[0].push_back(Bucket{i, 1, v, v, v, v, v, 1});
+    }
+    buildLevels();
+}
+
+/**
+ * buildLevels
+ * Merges pairs of buckets into the next level until one bucket is left. A merged
+ * bucket opens with the left one, closes with the right one, and takes the wider
+ * high/low and the summed sum/samples. An odd last bucket is carried up as is.
+ */
+void LodPyramid::buildLevels()
+{
+    while (levels.back().size() > 1) {
+        const auto& below = levels.back();
+        std::vector<Bucket> above;
+        above.reserve((below.size() + 1) / 2);
+        for (size_t i = 0; i < below.size(); i += 2) {
+            Bucket b = below[i];
+            if (i + 1 < below.size()) {
+                const Bucket& r = below[i + 1];
+                b.count  += r.count;
+                b.high    = std::max(b.high, r.high);
+                b.low     = std::min(b.low, r.low);
+                b.close   = r.close;
+                b.sum    += r.sum;
+                b.samples += r.samples;
+            }
+            above.push_back(b);
+        }
+        levels.push_back(std::move(above));
+    }
+}
+
+/**
+ * levelFor
+ * The coarsest level whose buckets still number at least maxBuckets / 2 across a
+ * window of `span` points (level L buckets cover 2^L points).
+ */
+size_t LodPyramid::levelFor(size_t span, size_t maxBuckets) const
+{
+    size_t level = 0;
+    maxBuckets = std::max<size_t>(maxBuckets, 1);
+    while (level + 1 < levels.size() && (span >> level) > maxBuckets) {
+        ++level;
+    }
+    return level;
+}
+
+/**
+ * query
+ * @return The buckets of the chosen level that overlap [from, to), in time order.
+ *         Buckets at the window edges may extend slightly past it.
+ */
+std::vector<LodPyramid::Bucket> LodPyramid::query(size_t from, size_t to, size_t maxBuckets) const
+{
+    to = std::min(to, size());
+    if (from >= to) {
+        return {};
+    }
+    size_t level = levelFor(to - from, maxBuckets);
+    const auto& buckets = levels[level];
+    size_t first = from >> level;
+    size_t last  = std::min(((to - 1) >> level) + 1, buckets.size());
+    return std::vector<Bucket>(buckets.begin() + static_cast<long>(first),
+                               buckets.begin() + static_cast<long>(last));
+}
+
+ChartViewport::ChartViewport(const LodPyramid& _pyramid, size_t _width)
+: pyramid(_pyramid),
+  width(std::max<size_t>(_width, 1)),
+  from(0),
+  to(_pyramid.size())
+{
+}
+
+/** Halve the visible span around its centre (down to `width` points, one per column). */
+void ChartViewport::zoomIn()
+{
+    size_t span = to - from;
+    size_t target = std::max(span / 2, std::min(width, pyramid.size()));
+    size_t centre = from + span / 2;
+    from = centre > target / 2 ? centre - target / 2 : 0;
+    to = from + target;
+    clamp();
+}
+
+/** Double the visible span around its centre (up to the whole series). */
+void ChartViewport::zoomOut()
+{
+    size_t span = std::max<size_t>(to - from, 1);
+    size_t target = std::min(span * 2, pyramid.size());
+    size_t centre = from + span / 2;
+    from = centre > target / 2 ? centre - target / 2 : 0;
+    to = from + target;
+    clamp();
+}
+
+/** Move by `steps` columns, i.e. steps * (span / width) points. */
+void ChartViewport::pan(long steps)
+{
+    size_t span = to - from;
+    long perColumn = static_cast<long>(std::max<size_t>(span / width, 1));
+    long shift = steps * perColumn;
+    if (shift < 0 && static_cast<size_t>(-shift) > from) {
+        shift = -static_cast<long>(from);
+    }
+    from = static_cast<size_t>(static_cast<long>(from) + shift);
+    to = from + span;
+    clamp();
+}
+
+void ChartViewport::setWindow(size_t _from, size_t _to)
+{
+    from = _from;
+    to = std::max(_to, _from + 1);
+    clamp();
+}
+
+/** Keep [from, to) inside the series, preserving the span where possible. */
+void ChartViewport::clamp()
+{
+    size_t n = pyramid.size();
+    size_t span = std::min(to - from, n);
+    if (to > n) {
+        to = n;
+        from = n - span;
+    }
+}
+
+std::vector<LodPyramid::Bucket> ChartViewport::visible() const
+{
+    return pyramid.query(from, to, width);
+}
+
+/**
+ * draw
+ * Converts the visible buckets to the plotter's inputs (a candle per bucket, or a
+ * (label, value) bar with the bucket's total volume / mean price) and draws them,
+ * followed by "[from .. to] of N, level L".
+ */
+void ChartViewport::draw() const
+{
+    auto buckets = visible();
+    if (buckets.empty()) {
+        std::cout << "No data to plot\n";
+        return;
+    }
+
+    if (pyramid.kind() == ChartKind::candles) {
+        std::vector<Candlestick> candles;
+        candles.reserve(buckets.size());
+        for (const auto& b : buckets) {
+            candles.emplace_back(pyramid.label(b.first), b.open, b.high, b.low, b.close);
+        }
+        TextPlotter::drawCandlesticks(candles, width);
+    } else {
+        std::vector<std::pair<std::string, double>> bars;
+        bars.reserve(buckets.size());
+        for (const auto& b : buckets) {
+            double value = (pyramid.kind() == ChartKind::volume)
+                               ? b.sum
+                               : b.sum / static_cast<double>(std::max<size_t>(b.samples, 1));
+            bars.emplace_back(pyramid.label(b.first), value);
+        }
+        if (pyramid.kind() == ChartKind::volume) {
+            TextPlotter::drawVolumeChart(bars, width);
+        } else {
+            TextPlotter::drawMeanPriceChart(bars, width);
+        }
+    }
+
+    std::cout << "[" << pyramid.label(from) << " .. " << pyramid.label(to - 1) << "] "
+              << (to - from) << " of " << pyramid.size() << " points, level "
+              << pyramid.levelFor(to - from, width) << "\n";
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+#include "Candlestick.h"
+
+/** Which chart a pyramid / viewport holds. */
+enum class ChartKind { candles, volume, meanPrice };
+
+/**
+ * LodPyramid: a chart series pre-aggregated at every power-of-two resolution.
+ *   - level 0 holds one bucket per input point; each level above merges pairs of the
+ *     level below, so all levels together are under twice the input size
+ *   - a bucket keeps open/high/low/close plus sum and count, which is enough to
+ *     draw it as a candle (OHLC), a volume bar (sum) or a mean-price bar (sum / count)
+ *   - query(from, to, maxBuckets) reads only the coarsest level that still gives
+ *     about maxBuckets buckets for that window, so the cost follows the screen size
+ */
+class LodPyramid {
+public:
+    struct Bucket
+    {
+        size_t first = 0;   // index of the first input point it covers
+        size_t count = 0;   // number of input points it covers
+        double open = 0, high = 0, low = 0, close = 0;
+        double sum = 0;     // sum of values (volume) or of per-point prices (mean price)
+        size_t samples = 0; // number of values added into `sum`
+    };
+
+    /** Build from candles (one bucket per candle). */
+    explicit LodPyramid(const std::vector<Candlestick>& candles);
+    /** Build from a (label, value) series, e.g. volume or mean price. */
+    LodPyramid(ChartKind kind, const std::vector<std::pair<std::string, double>>& series);
+
+    ChartKind kind() const { return seriesKind; }
+    /** Number of input points (the full time range is [0, size())). */
+    size_t size() const { return labels.size(); }
+    /** Label (timestamp / minute) of input point `i`. */
+    const std::string& label(size_t i) const { return labels[i]; }
+    /** Buckets covering input points [from, to) at the coarsest level giving >= maxBuckets / 2. */
+    std::vector<Bucket> query(size_t from, size_t to, size_t maxBuckets) const;
+    /** The level query() would read for a window of `span` points. */
+    size_t levelFor(size_t span, size_t maxBuckets) const;
+
+private:
+    void buildLevels();
+
+    ChartKind seriesKind;
+    std::vector<std::string> labels;
+    std::vector<std::vector<Bucket>> levels;
+};
+
+/**
+ * ChartViewport: a pannable, zoomable window over a pyramid.
+ *   - zoomIn()/zoomOut() halve/double the visible span around its centre
+ *   - pan(steps) moves the window by `steps` screen columns (negative = earlier)
+ *   - draw() renders just the visible buckets through TextPlotter
+ */
+class ChartViewport {
+public:
+    /** A viewport `width` columns (candles / bars) wide, initially showing everything. */
+    ChartViewport(const LodPyramid& pyramid, size_t width);
+
+    void zoomIn();
+    void zoomOut();
+    void pan(long steps);
+    /** Show input points [from, to) (clamped to the series). */
+    void setWindow(size_t from, size_t to);
+    size_t windowFrom() const { return from; }
+    size_t windowTo() const { return to; }
+
+    /** The visible buckets, at the resolution that fits `width`. */
+    std::vector<LodPyramid::Bucket> visible() const;
+    /** Render the visible window with TextPlotter, plus a one-line position summary. */
+    void draw() const;
+
+private:
+    void clamp();
+
+    const LodPyramid& pyramid;
+    size_t width;
+    size_t from = 0;
+    size_t to = 0;
+};
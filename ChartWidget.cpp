@@ -0,0 +1,274 @@
+#include "ChartWidget.h"
+#include <QPainter>
+#include <QPen>
+#include <QPaintEvent>
+#include <QPolygonF>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Pixels per candle / per volume bar or mean-price point
+    constexpr int kCandleStep = 6;
+    constexpr int kBarStep    = 3;
+    // Room for the value labels on the right and a title above each pane
+    constexpr int kScaleWidth = 72;
+    constexpr int kTitle      = 16;
+    constexpr int kMargin     = 6;
+
+    /** Highest / lowest values on the right edge of `area`. */
+    void drawScale(QPainter& p, const QRect& area, double lo, double hi)
+    {
+        p.setPen(Qt::darkGray);
+        p.drawText(QRect(area.right() + 4, area.top(), kScaleWidth - 4, kTitle),
+                   Qt::AlignLeft | Qt::AlignVCenter, QString::number(hi, 'g', 7));
+        p.drawText(QRect(area.right() + 4, area.bottom() - kTitle, kScaleWidth - 4, kTitle),
+                   Qt::AlignLeft | Qt::AlignVCenter, QString::number(lo, 'g', 7));
+        p.drawRect(area);
+    }
+
+    /** Pane title, left-aligned above `area`. */
+    void drawTitle(QPainter& p, const QRect& area, const QString& title)
+    {
+        p.setPen(Qt::black);
+        p.drawText(QRect(area.left(), area.top() - kTitle, area.width(), kTitle),
+                   Qt::AlignLeft | Qt::AlignVCenter, title);
+    }
+
+    /** How many of `total` points fit `width` pixels at `step` pixels each. */
+    size_t visibleCount(size_t total, int width, int step)
+    {
+        return std::min(total, static_cast<size_t>(std::max(width / step, 1)));
+    }
+}
+
+ChartWidget::ChartWidget(OrderBook& book,
+                         std::string product,
+                         OrderBookType side,
+                         QWidget* parent)
+    : QWidget(parent)
+    , m_book(book)
+    , m_product(std::move(product))
+    , m_side(side)
+{
+    setWindowTitle(QString::fromStdString(m_product) +
+                   (m_side == OrderBookType::ask ? " asks" : " bids"));
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+QSize ChartWidget::sizeHint() const
+{
+    return QSize(900, 600);
+}
+
+/**
+ * loadAll
+ * Seeds the widget with the whole book, replacing whatever it held: candles and
+ * volume from the book's aggregate series (getCandlestickData, getVolumeData), and
+ * the per-minute price sums timestamp by timestamp, so that later appendTimestamp
+ * calls keep extending true sums (getMeanPriceData only returns rounded means).
+ */
+void ChartWidget::loadAll()
+{
+    m_candles = m_book.getCandlestickData(m_side, m_product);
+    m_volume  = m_book.getVolumeData(m_side, m_product);
+    m_minutes.clear();
+    for (const auto& timestamp : m_book.getAllTimestamps()) {
+        auto entries = m_book.getOrders(m_side, m_product, timestamp);
+        double priceSum = 0.0;
+        for (auto& e : entries) {
+            priceSum += e.price;
+        }
+        addToMinute(timestamp, priceSum, entries.size());
+    }
+    update();
+}
+
+/**
+ * addToMinute
+ * Adds `count` prices summing to `priceSum` to the "HH:MM" minute of `timestamp`.
+ * Like OrderBook::getMeanPriceData, minutes are keyed by "HH:MM" alone (the same
+ * minute of different days is one point) and kept in "HH:MM" order.
+ */
+void ChartWidget::addToMinute(const std::string& timestamp, double priceSum, size_t count)
+{
+    if (count == 0 || timestamp.size() < 16) {
+        return;
+    }
+    std::string minute = timestamp.substr(11, 5);
+    auto it = std::lower_bound(m_minutes.begin(), m_minutes.end(), minute,
+                               [](const MinuteMean& m, const std::string& key) { return m.minute < key; });
+    if (it == m_minutes.end() || it->minute != minute) {
+        it = m_minutes.insert(it, MinuteMean{minute, 0.0, 0});
+    }
+    it->sum   += priceSum;
+    it->count += count;
+}
+
+/**
+ * appendTimestamp
+ * Reads only the orders at `timestamp` and extends the series the way the
+ * OrderBook aggregates would:
+ *   - a candle (VWAP close, open = previous close) if there are any orders
+ *   - a volume point (possibly 0) for every timestamp
+ *   - the prices go into the running mean of their "HH:MM" minute (addToMinute),
+ *     so after a day boundary they join the same minute of the earlier day, as
+ *     in getMeanPriceData
+ * Then schedules a repaint.
+ */
+void ChartWidget::appendTimestamp(const std::string& timestamp)
+{
+    auto entries = m_book.getOrders(m_side, m_product, timestamp);
+
+    double totVal = 0.0, totAmt = 0.0, priceSum = 0.0;
+    for (auto& e : entries) {
+        totVal   += e.price * e.amount;
+        totAmt   += e.amount;
+        priceSum += e.price;
+    }
+    m_volume.emplace_back(timestamp, totAmt);
+
+    if (!entries.empty() && totAmt > 0.0) {
+        double close = totVal / totAmt;
+        double open  = m_candles.empty() ? close : m_candles.back().close;
+        m_candles.emplace_back(timestamp,
+                               open,
+                               OrderBook::getHighPrice(entries),
+                               OrderBook::getLowPrice(entries),
+                               close);
+    }
+
+    addToMinute(timestamp, priceSum, entries.size());
+    update();
+}
+
+void ChartWidget::clear()
+{
+    m_candles.clear();
+    m_volume.clear();
+    m_minutes.clear();
+    update();
+}
+
+/**
+ * paintEvent
+ * Splits the widget into three panes (60% candles, 20% volume, 20% mean price)
+ * and draws the newest points that fit each one. Cost is O(widget width).
+ */
+void ChartWidget::paintEvent(QPaintEvent* /*event*/)
+{
+    QPainter p(this);
+    p.fillRect(rect(), Qt::white);
+    p.setRenderHint(QPainter::Antialiasing, false);
+
+    const int left   = kMargin;
+    const int width  = std::max(this->width() - kScaleWidth - 2 * kMargin, 10);
+    const int usable = std::max(height() - 3 * kTitle - 4 * kMargin, 30);
+
+    const int candleH = usable * 6 / 10;
+    const int volumeH = usable * 2 / 10;
+    const int meanH   = usable - candleH - volumeH;
+
+    QRect candles(left, kMargin + kTitle, width, candleH);
+    QRect volume(left, candles.bottom() + kMargin + kTitle, width, volumeH);
+    QRect mean(left, volume.bottom() + kMargin + kTitle, width, meanH);
+
+    paintCandles(p, candles);
+    paintVolume(p, volume);
+    paintMeanPrice(p, mean);
+}
+
+void ChartWidget::paintCandles(QPainter& p, const QRect& area) const
+{
+    drawTitle(p, area, windowTitle() + QString(" - %1 candles").arg(m_candles.size()));
+    if (m_candles.empty()) {
+        drawScale(p, area, 0.0, 0.0);
+        return;
+    }
+
+    size_t n = visibleCount(m_candles.size(), area.width(), kCandleStep);
+    auto first = m_candles.end() - static_cast<long>(n);
+
+    double lo = first->low, hi = first->high;
+    for (auto it = first; it != m_candles.end(); ++it) {
+        lo = std::min(lo, it->low);
+        hi = std::max(hi, it->high);
+    }
+    double range = (hi > lo) ? hi - lo : 1.0;
+    auto y = [&](double v) { return area.bottom() - (v - lo) / range * (area.height() - 1); };
+
+    int i = 0;
+    for (auto it = first; it != m_candles.end(); ++it, ++i) {
+        double x = area.left() + i * kCandleStep + kCandleStep / 2.0;
+        QColor colour = (it->close >= it->open) ? QColor(0, 150, 70) : QColor(200, 40, 40);
+        p.setPen(colour);
+        p.drawLine(QPointF(x, y(it->high)), QPointF(x, y(it->low)));
+        double top = y(std::max(it->open, it->close));
+        double bodyH = std::max(std::abs(y(it->open) - y(it->close)), 1.0);
+        p.fillRect(QRectF(x - 2.0, top, 4.0, bodyH), colour);
+    }
+
+    drawScale(p, area, lo, hi);
+    p.drawText(QRect(area.left(), area.bottom() - kTitle, area.width() - 4, kTitle),
+               Qt::AlignRight | Qt::AlignVCenter,
+               QString::fromStdString(m_candles.back().timestamp));
+}
+
+void ChartWidget::paintVolume(QPainter& p, const QRect& area) const
+{
+    drawTitle(p, area, "Volume");
+    if (m_volume.empty()) {
+        drawScale(p, area, 0.0, 0.0);
+        return;
+    }
+
+    size_t n = visibleCount(m_volume.size(), area.width(), kBarStep);
+    auto first = m_volume.end() - static_cast<long>(n);
+
+    double hi = 0.0;
+    for (auto it = first; it != m_volume.end(); ++it) {
+        hi = std::max(hi, it->second);
+    }
+    double scale = (hi > 0.0) ? (area.height() - 1) / hi : 0.0;
+
+    int i = 0;
+    for (auto it = first; it != m_volume.end(); ++it, ++i) {
+        double h = it->second * scale;
+        p.fillRect(QRectF(area.left() + i * kBarStep, area.bottom() - h, kBarStep - 1, h),
+                   QColor(70, 110, 180));
+    }
+    drawScale(p, area, 0.0, hi);
+}
+
+void ChartWidget::paintMeanPrice(QPainter& p, const QRect& area) const
+{
+    drawTitle(p, area, "Mean price per minute");
+    if (m_minutes.empty()) {
+        drawScale(p, area, 0.0, 0.0);
+        return;
+    }
+
+    size_t n = visibleCount(m_minutes.size(), area.width(), kBarStep);
+    auto first = m_minutes.end() - static_cast<long>(n);
+
+    // Same rounding as OrderBook::getMeanPriceData
+    std::vector<double> means;
+    means.reserve(n);
+    for (auto it = first; it != m_minutes.end(); ++it) {
+        double avg = it->sum / static_cast<double>(std::max<size_t>(it->count, 1));
+        means.push_back(std::round(avg * 1e6) / 1e6);
+    }
+    auto [loIt, hiIt] = std::minmax_element(means.begin(), means.end());
+    double lo = *loIt, hi = *hiIt;
+    double range = (hi > lo) ? hi - lo : 1.0;
+
+    QPolygonF line;
+    line.reserve(static_cast<int>(means.size()));
+    for (size_t i = 0; i < means.size(); ++i) {
+        line << QPointF(area.left() + static_cast<double>(i) * kBarStep,
+                        area.bottom() - (means[i] - lo) / range * (area.height() - 1));
+    }
+    p.setPen(QPen(QColor(120, 60, 160), 1.5));
+    p.drawPolyline(line);
+    drawScale(p, area, lo, hi);
+}
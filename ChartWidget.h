@@ -0,0 +1,64 @@
+#pragma once
+#include <QWidget>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Candlestick.h"
+#include "OrderBook.h"
+
+class QPainter;
+
+/* Native chart of one product and side: candlesticks on top, volume bars and
+ * the per-minute mean price underneath.  The series grow one timestamp at a
+ * time (appendTimestamp), so advancing the simulation only reads the orders
+ * of the new timestamp.  Paints the newest points that fit the widget; works
+ * on the "offscreen" platform, e.g. grab().save("chart.png"). */
+class ChartWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    ChartWidget(OrderBook& book,
+                std::string product,
+                OrderBookType side = OrderBookType::ask,
+                QWidget* parent = nullptr);
+
+    /** Replace the series with the book's full aggregate series. */
+    void loadAll();
+    /** Add the candle, volume and mean-price point for one timestamp. */
+    void appendTimestamp(const std::string& timestamp);
+    /** Drop every point. */
+    void clear();
+
+    const std::string& product() const { return m_product; }
+    size_t candleCount() const { return m_candles.size(); }
+    size_t volumeCount() const { return m_volume.size(); }
+    size_t minuteCount() const { return m_minutes.size(); }
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    /* Running per-minute mean, so a minute can keep taking prices. m_minutes is
+     * sorted by "HH:MM", one entry per minute of the day (as getMeanPriceData). */
+    struct MinuteMean
+    {
+        std::string minute;   // "HH:MM"
+        double sum = 0.0;
+        size_t count = 0;
+    };
+
+    void addToMinute(const std::string& timestamp, double priceSum, size_t count);
+    void paintCandles(QPainter& p, const QRect& area) const;
+    void paintVolume(QPainter& p, const QRect& area) const;
+    void paintMeanPrice(QPainter& p, const QRect& area) const;
+
+    OrderBook&    m_book;
+    std::string   m_product;
+    OrderBookType m_side;
+
+    std::vector<Candlestick>                    m_candles;
+    std::vector<std::pair<std::string, double>> m_volume;
+    std::vector<MinuteMean>                     m_minutes;
+};
@@ -0,0 +1,92 @@
+#include "CurrencyRegistry.h"
+
+/**
+ * CurrencyRegistry:
+ *   Hands out one dense ID per currency name. Wallets index their balance arrays by
+ *   these IDs, so after a currency's first sighting no string is hashed or compared.
+ */
+
+/**
+ * idOf
+ * Returns the ID for `name`, assigning the next free ID if it is new.
+ */
+CurrencyId CurrencyRegistry::idOf(std::string_view name)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    CurrencyId id = static_cast<CurrencyId>(names.size());
+    names.emplace_back(name);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+/**
+ * nameOf
+ * Returns the currency name for `id`, or an empty string for an unknown ID.
+ */
+std::string CurrencyRegistry::nameOf(CurrencyId id) const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return id < names.size() ? names[id] : std::string{};
+}
+
+/**
+ * size
+ * Number of currencies registered so far.
+ */
+size_t CurrencyRegistry::size() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return names.size();
+}
+
+/**
+ * splitProduct
+ * Splits a "BASE/QUOTE" product at its '/' and returns both currencies' IDs.
+ *
+ * @param product  e.g. "ETH/USDT"
+ * @param out      Receives { idOf("ETH"), idOf("USDT") }.
+ * @return false if there is no '/' or either side is empty.
+ */
+bool CurrencyRegistry::splitProduct(std::string_view product, ProductCurrencies& out)
+{
+    size_t slash = product.find('/');
+    if (slash == std::string_view::npos || slash == 0 || slash + 1 == product.size()) {
+        return false;
+    }
+    out.base  = idOf(product.substr(0, slash));
+    out.quote = idOf(product.substr(slash + 1));
+    return true;
+}
+
+/**
+ * shared
+ * The process-wide registry. Never destroyed, so IDs stay valid for the whole run.
+ */
+CurrencyRegistry& CurrencyRegistry::shared()
+{
+    static CurrencyRegistry* registry = new CurrencyRegistry();
+    return *registry;
+}
+
+/**
+ * lookup
+ * Returns the cached IDs for `product`, splitting and caching it on first sight.
+ * The product's characters are pooled, so the data pointer identifies it.
+ */
+bool ProductCurrencyCache::lookup(PooledString product, CurrencyRegistry::ProductCurrencies& out)
+{
+    auto it = products.find(product.data());
+    if (it != products.end()) {
+        out = it->second;
+        return true;
+    }
+    if (!CurrencyRegistry::shared().splitProduct(product, out)) {
+        return false;
+    }
+    products.emplace(product.data(), out);
+    return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include "StringPool.h"
+/**
+ * Dense numeric ID of a currency (e.g. "BTC"), assigned in order of first sight.
+ */
+using CurrencyId = std::uint32_t;
+
+/**
+ * CurrencyRegistry: interns currency names into dense IDs.
+ *   - idOf("BTC") returns the same small integer every time, so balances can live in
+ *     plain arrays indexed by ID instead of string-keyed maps
+ *   - nameOf(id) maps back for display
+ *   - splitProduct("ETH/USDT") returns the (base, quote) IDs of a product
+ */
+class CurrencyRegistry
+{
+    public:
+    /** Base and quote currency of a "BASE/QUOTE" product. */
+        struct ProductCurrencies
+        {
+            CurrencyId base;
+            CurrencyId quote;
+        };
+
+    /** Return the ID of `name`, registering it on first sight. Thread-safe. */
+        CurrencyId idOf(std::string_view name);
+    /** Return the name registered for `id`. */
+        std::string nameOf(CurrencyId id) const;
+    /** Number of currencies registered so far (IDs are 0 .. size()-1). */
+        size_t size() const;
+    /**
+     * Split "BASE/QUOTE" and register both halves. Returns false (leaving `out`
+     * untouched) if `product` is not of that form.
+     */
+        bool splitProduct(std::string_view product, ProductCurrencies& out);
+
+    /** The process-wide registry shared by every Wallet. */
+        static CurrencyRegistry& shared();
+
+    private:
+    /** Lets `ids` be searched with a string_view without building a std::string. */
+        struct NameHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+        };
+
+        std::unordered_map<std::string, CurrencyId, NameHash, std::equal_to<>> ids;
+        std::vector<std::string> names;
+        mutable std::mutex mutex;
+};
+
+/**
+ * ProductCurrencyCache: the (BASE, QUOTE) IDs of the products one owner has seen.
+ *   - a product string is split (CurrencyRegistry::splitProduct) only on first sight
+ *   - keyed by the product's pooled characters, so a lookup is one pointer hash
+ *   - not thread-safe: each Wallet / WalletManager keeps its own
+ */
+class ProductCurrencyCache
+{
+    public:
+    /** (BASE, QUOTE) of `product`; false if it is not of the form "BASE/QUOTE". */
+        bool lookup(PooledString product, CurrencyRegistry::ProductCurrencies& out);
+
+    private:
+        std::unordered_map<const char*, CurrencyRegistry::ProductCurrencies> products;
+};
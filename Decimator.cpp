@@ -0,0 +1,145 @@
+#include "Decimator.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Decimator:
+ *   All three reductions walk the input once and write at most the requested number of
+ *   points, so drawing a chart costs O(series) to reduce plus O(screen) to render.
+ *   Buckets are contiguous index ranges [i*n/k, (i+1)*n/k), which spreads any
+ *   remainder evenly instead of leaving a short last bucket.
+ */
+
+/**
+ * mergeCandles
+ * @param candles     Candles in time order.
+ * @param maxCandles  Upper bound on the result size (0 = no limit).
+ * @return            At most maxCandles candles covering the same time span.
+ */
+std::vector<Candlestick> Decimator::mergeCandles(const std::vector<Candlestick>& candles,
+                                                 size_t maxCandles)
+{
+    const size_t n = candles.size();
+    if (maxCandles == 0 || n <= maxCandles) {
+        return candles;
+    }
+
+    std::vector<Candlestick> merged;
+    merged.reserve(maxCandles);
+    for (size_t b = 0; b < maxCandles; ++b) {
+        size_t from = b * n / maxCandles;
+        size_t to   = (b + 1) * n / maxCandles;
+
+        const Candlestick& first = candles[from];
+        double high = first.high;
+        double low  = first.low;
+        for (size_t i = from + 1; i < to; ++i) {
+            high = std::max(high, candles[i].high);
+            low  = std::min(low,  candles[i].low);
+        }
+        merged.emplace_back(first.timestamp, first.open, high, low, candles[to - 1].close);
+    }
+    return merged;
+}
+
+/**
+ * minMax
+ * @param series     (label, value) points in order.
+ * @param maxPoints  Upper bound on the result size (0 = no limit).
+ * @return           Each bucket's min and max point (one point if they coincide).
+ */
+Decimator::Series Decimator::minMax(const Series& series, size_t maxPoints)
+{
+    const size_t n = series.size();
+    if (maxPoints == 0 || n <= maxPoints) {
+        return series;
+    }
+    if (maxPoints < 2) {
+        // Not enough room for a pair: keep the single largest point
+        auto top = std::max_element(series.begin(), series.end(),
+                                    [](const auto& a, const auto& b) { return a.second < b.second; });
+        return Series{*top};
+    }
+
+    const size_t buckets = maxPoints / 2;
+    Series reduced;
+    reduced.reserve(buckets * 2);
+    for (size_t b = 0; b < buckets; ++b) {
+        size_t from = b * n / buckets;
+        size_t to   = (b + 1) * n / buckets;
+
+        size_t lo = from, hi = from;
+        for (size_t i = from + 1; i < to; ++i) {
+            if (series[i].second < series[lo].second) lo = i;
+            if (series[i].second > series[hi].second) hi = i;
+        }
+        // Emit in time order so the chart still reads left to right / top to bottom
+        reduced.push_back(series[std::min(lo, hi)]);
+        if (lo != hi) {
+            reduced.push_back(series[std::max(lo, hi)]);
+        }
+    }
+    return reduced;
+}
+
+/**
+ * lttb
+ * @param series     (label, value) points in order.
+ * @param maxPoints  Upper bound on the result size (0 = no limit).
+ * @return           The selected points, in order; always includes the first and last.
+ */
+Decimator::Series Decimator::lttb(const Series& series, size_t maxPoints)
+{
+    const size_t n = series.size();
+    if (maxPoints == 0 || n <= maxPoints) {
+        return series;
+    }
+    if (maxPoints < 3) {
+        Series ends{series.front()};
+        if (maxPoints == 2) ends.push_back(series.back());
+        return ends;
+    }
+
+    Series reduced;
+    reduced.reserve(maxPoints);
+    reduced.push_back(series.front());
+
+    // The n-2 interior points are split into maxPoints-2 buckets
+    const size_t inner = n - 2;
+    const size_t buckets = maxPoints - 2;
+    size_t prev = 0;   // index of the last selected point
+    for (size_t b = 0; b < buckets; ++b) {
+        size_t from = 1 + b * inner / buckets;
+        size_t to   = 1 + (b + 1) * inner / buckets;
+
+        // Average of the next bucket (or the last point, after the final bucket)
+        size_t nextFrom = to;
+        size_t nextTo   = (b + 1 < buckets) ? 1 + (b + 2) * inner / buckets : n;
+        double avgX = 0.0, avgY = 0.0;
+        for (size_t i = nextFrom; i < nextTo; ++i) {
+            avgX += static_cast<double>(i);
+            avgY += series[i].second;
+        }
+        double count = static_cast<double>(nextTo - nextFrom);
+        avgX /= count;
+        avgY /= count;
+
+        // Point in this bucket with the largest triangle (prev, point, next average)
+        double px = static_cast<double>(prev), py = series[prev].second;
+        size_t best = from;
+        double bestArea = -1.0;
+        for (size_t i = from; i < to; ++i) {
+            double area = std::abs((px - avgX) * (series[i].second - py) -
+                                   (px - static_cast<double>(i)) * (avgY - py));
+            if (area > bestArea) {
+                bestArea = area;
+                best = i;
+            }
+        }
+        reduced.push_back(series[best]);
+        prev = best;
+    }
+
+    reduced.push_back(series.back());
+    return reduced;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+#include "Candlestick.h"
+
+/**
+ * Decimator: shrinks a chart series to what the screen can show, in one pass.
+ *   - mergeCandles(...) – OHLC-preserving merge of runs of adjacent candles
+ *   - minMax(...)       – keeps each bucket's lowest and highest point (spikes survive)
+ *   - lttb(...)         – Largest-Triangle-Three-Buckets, keeps the visual shape of a line
+ * A series already within the limit is returned unchanged.
+ */
+class Decimator {
+public:
+    using Series = std::vector<std::pair<std::string, double>>;
+
+    /**
+     * Merge runs of adjacent candles so at most `maxCandles` remain. Each merged candle
+     * takes the first candle's timestamp and open, the last one's close, and the
+     * highest high / lowest low of the run.
+     */
+    static std::vector<Candlestick> mergeCandles(const std::vector<Candlestick>& candles,
+                                                 size_t maxCandles);
+    /**
+     * Reduce to at most `maxPoints` by splitting the series into maxPoints/2 buckets and
+     * keeping each bucket's minimum and maximum, in their original order.
+     */
+    static Series minMax(const Series& series, size_t maxPoints);
+    /**
+     * Reduce to at most `maxPoints` with Largest-Triangle-Three-Buckets (x = index):
+     * keeps the first and last points and, from each bucket between, the point forming
+     * the largest triangle with the previous pick and the next bucket's average.
+     */
+    static Series lttb(const Series& series, size_t maxPoints);
+};
@@ -0,0 +1,147 @@
+#include "Logger.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+/**
+ * Logger:
+ *   Callers only append to a string under a mutex; a writer thread swaps the buffer out
+ *   and writes it to the sink in one call. The writer wakes when the buffer grows past
+ *   kFlushBytes, when flush() asks for it, or every kFlushInterval, so interactive output
+ *   still shows up promptly while a replay producing thousands of lines costs a handful
+ *   of writes.
+ */
+
+namespace
+{
+    constexpr size_t kFlushBytes = 64 * 1024;
+    constexpr auto   kFlushInterval = std::chrono::milliseconds(50);
+}
+
+/**
+ * Constructor
+ * Starts at LogLevel::info, writing to std::cout, and starts the writer thread.
+ */
+Logger::Logger()
+: minLevel(static_cast<int>(LogLevel::info)),
+  sink(&std::cout)
+{
+    writer = std::thread(&Logger::run, this);
+}
+
+/**
+ * Destructor
+ * Writes out anything still buffered, then stops the writer thread.
+ */
+Logger::~Logger()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+void Logger::setLevel(LogLevel level)
+{
+    minLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() const
+{
+    return static_cast<LogLevel>(minLevel.load(std::memory_order_relaxed));
+}
+
+/**
+ * setSink
+ * Redirects future writes. Lines already buffered go to the new sink.
+ */
+void Logger::setSink(std::ostream* out)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    sink = out;
+}
+
+/**
+ * write
+ * Appends `line` and a newline to the buffer, waking the writer once the buffer is large.
+ */
+void Logger::write(LogLevel level, std::string_view line)
+{
+    if (!enabled(level)) {
+        return;
+    }
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.append(line);
+        pending.push_back('\n');
+        full = pending.size() >= kFlushBytes;
+    }
+    if (full) {
+        wake.notify_one();
+    }
+}
+
+/**
+ * flush
+ * Takes a ticket and waits until the writer has served it, i.e. written out everything
+ * that was buffered when flush() was called.
+ */
+void Logger::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    unsigned long long ticket = ++requested;
+    wake.notify_one();
+    drained.wait(lock, [&] { return completed >= ticket; });
+}
+
+/**
+ * run
+ * Writer thread: swap the buffer out under the lock, write it without the lock held,
+ * then report which flush tickets that write covered. Exits once stopping is set and
+ * the buffer is empty.
+ */
+void Logger::run()
+{
+    std::string batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait_for(lock, kFlushInterval, [&] {
+            return stopping || requested > completed || pending.size() >= kFlushBytes;
+        });
+
+        unsigned long long ticket = requested;
+        std::ostream* out = sink;
+        batch.swap(pending);
+        lock.unlock();
+        if (out && !batch.empty()) {
+            out->write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            out->flush();
+        }
+        batch.clear();
+        lock.lock();
+
+        completed = ticket;
+        drained.notify_all();
+        if (stopping && pending.empty()) {
+            return;
+        }
+    }
+}
+
+/**
+ * shared
+ * The logger is created on first use and intentionally never destroyed by static
+ * destruction (other statics may still log); an atexit handler flushes it instead.
+ */
+Logger& Logger::shared()
+{
+    static Logger* instance = [] {
+        Logger* logger = new Logger();
+        std::atexit([] { Logger::shared().flush(); });
+        return logger;
+    }();
+    return *instance;
+}
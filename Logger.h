@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/** Severity of a log line; a logger drops lines below its current level. */
+enum class LogLevel { debug, info, warn, error, off };
+
+/**
+ * Logger: leveled, buffered logging for the library code.
+ *   - write(level, line) appends to an in-memory buffer; a background thread writes the
+ *     buffer to the sink (std::cout by default) in large chunks, so callers never block
+ *     on console I/O
+ *   - setLevel(LogLevel::warn) gives a quiet mode; LogLevel::off silences everything
+ *   - flush() waits until everything written so far has reached the sink
+ *   - use it through the LOG_* macros below, which skip formatting for disabled levels;
+ *     LOG_DEBUG compiles to nothing unless MERKEL_DEBUG_LOG is defined
+ */
+class Logger
+{
+    public:
+        Logger();
+        ~Logger();
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+    /** Lines below `level` are dropped. */
+        void setLevel(LogLevel level);
+        LogLevel getLevel() const;
+    /** True if a line at `level` would be kept (a single relaxed atomic load). */
+        bool enabled(LogLevel level) const
+        {
+            return static_cast<int>(level) >= minLevel.load(std::memory_order_relaxed);
+        }
+    /** Where buffered lines go; nullptr discards them. */
+        void setSink(std::ostream* out);
+    /** Queue one line (a newline is appended). */
+        void write(LogLevel level, std::string_view line);
+    /** Block until every line queued so far has been written to the sink. */
+        void flush();
+    /** The process-wide logger; it is flushed and stopped at exit. */
+        static Logger& shared();
+
+    private:
+        void run();
+
+        std::atomic<int> minLevel;
+        std::ostream* sink;
+        std::string pending;                // lines waiting for the writer thread
+        unsigned long long requested = 0;   // flush tickets handed out
+        unsigned long long completed = 0;   // flush tickets the writer has served
+        bool stopping = false;
+        std::mutex mutex;
+        std::condition_variable wake;       // writer: there is work
+        std::condition_variable drained;    // flush(): the writer caught up
+        std::thread writer;
+};
+
+#define MERKEL_LOG(level, expr)                                         \
+    do {                                                                \
+        if (Logger::shared().enabled(level)) {                          \
+            std::ostringstream merkelLogLine_;                          \
+            merkelLogLine_ << expr;                                     \
+            Logger::shared().write(level, merkelLogLine_.str());        \
+        }                                                               \
+    } while (0)
+
+#ifdef MERKEL_DEBUG_LOG
+#define LOG_DEBUG(expr) MERKEL_LOG(LogLevel::debug, expr)
+#else
+#define LOG_DEBUG(expr) do { } while (0)
+#endif
+#define LOG_INFO(expr)  MERKEL_LOG(LogLevel::info, expr)
+#define LOG_WARN(expr)  MERKEL_LOG(LogLevel::warn, expr)
+#define LOG_ERROR(expr) MERKEL_LOG(LogLevel::error, expr)
@@ -3,8 +3,16 @@
 #include "OrderBookEntry.h"
 #include "TextPlotter.h"
 #include "Candlestick.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "ChartViewport.h"
+#include "ChartWidget.h"
+#include "OrderBookVersions.h"
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <memory>
 
 MerkelMain::MerkelMain(OrderBook& book,
                        Wallet&    wal,
@@ -14,13 +22,17 @@ MerkelMain::MerkelMain(OrderBook& book,
   , orderBook(book)
   , wallet(wal)
   , products(prods)
+  , sim(book, wal)   // starts at the earliest time in the book
+  , versions(book)
 {
-    // set the starting time
-    currentTime = orderBook.getEarliestTime();
 }
 
 void MerkelMain::printMenu()
 {
+    // Draw any background charts that finished since the last prompt
+    showFinishedCharts(false);
+    // Let buffered log lines from the last action appear before the prompt
+    Logger::shared().flush();
     std::cout
       << "1: Print help\n"
       << "2: Print exchange stats\n"
@@ -32,6 +44,10 @@ void MerkelMain::printMenu()
       << "8: Print volume chart\n"
     << "9: Print average price chart\n"
     << "10: Print number of trades per product\n"
+    << "11: Print performance stats\n"
+    << "12: Explore chart (zoom / pan)\n"
+    << "13: Open chart window\n"
+    << "14: Wait for background charts\n"
       << "0: Quit\n"
       << "Enter option: ";
 }
@@ -61,9 +77,13 @@ void MerkelMain::processUserOption(int choice)
       case 8: printVolumeChart();      break;
         case 9: printMeanPriceChart(); break;
         case 10: printTradesPerProduct(); break;
+        case 11: printStats();            break;
+        case 12: exploreChart();          break;
+        case 13: openChartWindow();       break;
+        case 14: showFinishedCharts(true); break;
       case 0: std::exit(0);            break;
       default:
-        std::cout << "Invalid choice, please type 0–8\n";
+        std::cout << "Invalid choice, please type 0–14\n";
     }
 }
 
@@ -81,7 +101,7 @@ void MerkelMain::printMarketStats()
     for (auto const& p : orderBook.getKnownProducts())
     {
         std::cout << "Product: " << p << "\n";
-        auto asks = orderBook.getOrders(OrderBookType::ask, p, currentTime);
+        auto asks = orderBook.getOrders(OrderBookType::ask, p, sim.currentTime());
         std::cout << "Asks seen: " << asks.size() << "\n";
         std::cout << "Max ask: " << OrderBook::getHighPrice(asks) << "\n";
         std::cout << "Min ask: " << OrderBook::getLowPrice(asks) << "\n";
@@ -101,13 +121,14 @@ void MerkelMain::enterAsk()
     }
     try {
         auto obe = CSVReader::stringsToOBE(
-            tokens[1], tokens[2], currentTime, tokens[0], OrderBookType::ask);
-        obe.username = "simuser";
-        if (wallet.canFulfillOrder(obe)) {
-            orderBook.insertOrder(obe);
-            std::cout << "Ask placed.\n";
-        } else {
+            tokens[1], tokens[2], sim.currentTime(), tokens[0], OrderBookType::ask);
+        // Entered into the book by the next Continue, along with any other queued orders
+        if (!wallet.canFulfillOrder(obe)) {
             std::cout << "Insufficient funds.\n";
+        } else if (sim.submitOrder(obe)) {
+            std::cout << "Ask queued for " << sim.currentTime() << ".\n";
+        } else {
+            std::cout << "Order queue is full; continue to the next time frame first.\n";
         }
     } catch (...) {
         std::cout << "Error parsing input.\n";
@@ -127,13 +148,14 @@ void MerkelMain::enterBid()
     }
     try {
         auto obe = CSVReader::stringsToOBE(
-            tokens[1], tokens[2], currentTime, tokens[0], OrderBookType::bid);
-        obe.username = "simuser";
-        if (wallet.canFulfillOrder(obe)) {
-            orderBook.insertOrder(obe);
-            std::cout << "Bid placed.\n";
-        } else {
+            tokens[1], tokens[2], sim.currentTime(), tokens[0], OrderBookType::bid);
+        // Entered into the book by the next Continue, along with any other queued orders
+        if (!wallet.canFulfillOrder(obe)) {
             std::cout << "Insufficient funds.\n";
+        } else if (sim.submitOrder(obe)) {
+            std::cout << "Bid queued for " << sim.currentTime() << ".\n";
+        } else {
+            std::cout << "Order queue is full; continue to the next time frame first.\n";
         }
     } catch (...) {
         std::cout << "Error parsing input.\n";
@@ -148,19 +170,24 @@ void MerkelMain::printWallet()
 void MerkelMain::gotoNextTimeframe()
 {
     std::cout << "Going to next time frame...\n";
-    for (auto const& p : orderBook.getKnownProducts())
+    // Match every product, settle the user's fills and advance the clock
+    auto result = sim.step();
+    if (result.queuedPlaced > 0)
+        versions.publish();   // background charts see the new orders from now on
+    if (result.queuedRejected > 0)
+        std::cout << result.queuedRejected << " queued order(s) rejected: insufficient funds\n";
+    for (auto& sale : result.sales)
     {
-        auto sales = orderBook.matchAsksToBids(p, currentTime);
-        for (auto& sale : sales)
-        {
-            std::cout << "Sale " << p
-                      << " price: " << sale.price
-                      << " amount: " << sale.amount << "\n";
-            if (sale.username == "simuser")
-                wallet.processSale(sale);
-        }
+        std::cout << "Sale " << sale.product
+                  << " price: " << sale.price
+                  << " amount: " << sale.amount << "\n";
     }
-    currentTime = orderBook.getNextTime(currentTime);
+    if (result.settlement.fills > 0)
+        std::cout << "Settled " << result.settlement.toString() << "\n";
+
+    // Extend the chart window with just the timestamp that was matched
+    if (chartWindow)
+        chartWindow->appendTimestamp(result.timestamp);
 }
 
 void MerkelMain::printCandlestickChart() {
@@ -169,17 +196,16 @@ void MerkelMain::printCandlestickChart() {
     std::getline(std::cin, prod);
     if (prod.empty()) std::getline(std::cin, prod);
 
-    auto candles = orderBook.getCandlestickData(OrderBookType::ask, prod);
-    const size_t MAX_CANDLES = 50;
-        if (candles.size() > MAX_CANDLES) {
-                // keep only the final MAX_CANDLES entries
-                candles = std::vector<Candlestick>(
-                    candles.end() - MAX_CANDLES,
-                    candles.end()
-                );
-           }
-
-    TextPlotter::drawCandlesticks(candles);
+    // Computed on a worker; printMenu draws it once ready. The whole series is
+    // fetched and the plotter merges candles down to the terminal width.
+    submitChart("candles", [this, prod] {
+        auto candles = versions.snapshot().getCandlestickData(OrderBookType::ask, prod);
+        return ChartDraw([prod, candles = std::move(candles)] {
+            std::cout << "Candlestick chart for " << prod << ":\n";
+            TextPlotter::drawCandlesticks(candles);
+        });
+    });
+    std::cout << "Computing candlestick chart for " << prod << "...\n";
 }
 void MerkelMain::printVolumeChart()
 {
@@ -188,8 +214,14 @@ void MerkelMain::printVolumeChart()
     std::getline(std::cin, prod);
     if (prod.empty()) std::getline(std::cin, prod);
 
-    auto vol = orderBook.getVolumeData(OrderBookType::ask, prod);
-    TextPlotter::drawVolumeChart(vol);
+    submitChart("volume", [this, prod] {
+        auto vol = versions.snapshot().getVolumeData(OrderBookType::ask, prod);
+        return ChartDraw([prod, vol = std::move(vol)] {
+            std::cout << "Volume chart for " << prod << ":\n";
+            TextPlotter::drawVolumeChart(vol);
+        });
+    });
+    std::cout << "Computing volume chart for " << prod << "...\n";
 }
 void MerkelMain::printMeanPriceChart()
 {
@@ -210,21 +242,145 @@ void MerkelMain::printMeanPriceChart()
     std::getline(std::cin, choice);
     OrderBookType side = (choice == "1" ? OrderBookType::ask : OrderBookType::bid);
 
-    // Fetch and draw
-    auto data = orderBook.getMeanPriceData(side, prod);
-    if (data.empty()) {
-        std::cout << "No mean price data for \"" << prod << "\" on that side.\n";
-        return;
-    }
-    TextPlotter::drawMeanPriceChart(data);
+    // Fetch on a worker, draw from printMenu
+    submitChart("meanPrice", [this, prod, side] {
+        auto data = versions.snapshot().getMeanPriceData(side, prod);
+        return ChartDraw([prod, data = std::move(data)] {
+            if (data.empty()) {
+                std::cout << "No mean price data for \"" << prod << "\" on that side.\n";
+                return;
+            }
+            std::cout << "Mean price chart for " << prod << ":\n";
+            TextPlotter::drawMeanPriceChart(data);
+        });
+    });
+    std::cout << "Computing mean price chart for " << prod << "...\n";
 }
 
 
 void MerkelMain::printTradesPerProduct()
 {
-    auto counts = orderBook.getTradesPerProduct();
+    TradeCounts counts = orderBook.countTrades();
     std::cout << "Total trades per product:\n";
-    for (auto& [product, count] : counts) {
+    for (auto& [product, count] : counts.byProduct) {
         std::cout << product << ": " << count << " orders\n";
     }
+    std::cout << "Asks: " << counts.bySide[OrderBookType::ask]
+              << ", bids: " << counts.bySide[OrderBookType::bid]
+              << " (" << counts.total << " orders in all)\n";
+    std::cout << "Per user:\n";
+    for (auto& [user, count] : counts.byUser) {
+        std::cout << user << ": " << count << " orders\n";
+    }
+}
+
+void MerkelMain::exploreChart()
+{
+    std::cout << "Enter product (e.g. ETH/USDT): ";
+    std::string prod;
+    std::getline(std::cin, prod);
+    if (prod.empty()) std::getline(std::cin, prod);
+
+    std::cout << "Chart (1) candlestick, (2) volume or (3) mean price? ";
+    std::string choice;
+    std::getline(std::cin, choice);
+
+    // Build the pyramid once; every zoom/pan below reads only the visible buckets
+    std::unique_ptr<LodPyramid> pyramid;
+    if (choice == "2") {
+        pyramid = std::make_unique<LodPyramid>(ChartKind::volume,
+                                               orderBook.getVolumeData(OrderBookType::ask, prod));
+    } else if (choice == "3") {
+        pyramid = std::make_unique<LodPyramid>(ChartKind::meanPrice,
+                                               orderBook.getMeanPriceData(OrderBookType::ask, prod));
+    } else {
+        pyramid = std::make_unique<LodPyramid>(orderBook.getCandlestickData(OrderBookType::ask, prod));
+    }
+    if (pyramid->size() == 0) {
+        std::cout << "No data for \"" << prod << "\".\n";
+        return;
+    }
+
+    // Candles run across the screen; volume / mean price bars run down it
+    size_t width = pyramid->kind() == ChartKind::candles
+                       ? std::max<size_t>(TextPlotter::terminalColumns(), 34) - 24
+                       : TextPlotter::terminalRows();
+    ChartViewport view(*pyramid, width);
+    for (;;) {
+        view.draw();
+        std::cout << "+ zoom in, - zoom out, < / > pan (e.g. <10), q quit: ";
+        std::string cmd;
+        if (!std::getline(std::cin, cmd) || cmd.empty() || cmd[0] == 'q') {
+            return;
+        }
+        long steps = 1;
+        if (cmd.size() > 1) {
+            try { steps = std::stol(cmd.substr(1)); } catch (...) { steps = 1; }
+        }
+        switch (cmd[0]) {
+            case '+': view.zoomIn();       break;
+            case '-': view.zoomOut();      break;
+            case '<': view.pan(-steps);    break;
+            case '>': view.pan(steps);     break;
+            default:  std::cout << "Unknown command\n"; break;
+        }
+    }
+}
+
+void MerkelMain::openChartWindow()
+{
+    std::cout << "Enter product for the chart window (e.g. ETH/USDT): ";
+    std::string prod;
+    std::getline(std::cin, prod);
+    if (prod.empty()) std::getline(std::cin, prod);
+
+    // One window at a time; it starts empty and grows with each Continue (option 6)
+    if (chartWindow)
+        chartWindow->close();
+    chartWindow = new ChartWidget(orderBook, prod);
+    chartWindow->setAttribute(Qt::WA_DeleteOnClose);
+    chartWindow->show();
+    std::cout << "Chart window opened; points are added as you continue.\n";
+}
+
+/**
+ * submitChart
+ * Queues `job` on the analytics worker under `channel`; a newer request on the same
+ * channel (e.g. a second candlestick chart) supersedes it. The job computes the series
+ * from a snapshot of the book (versions.snapshot()), so it never races the menu's own
+ * inserts and matching, and returns the drawing step, which runs on this thread.
+ */
+void MerkelMain::submitChart(const std::string& channel, std::function<ChartDraw()> job)
+{
+    pendingCharts.push_back(analytics.submit(channel, std::move(job)));
+}
+
+/**
+ * showFinishedCharts
+ * Draws the charts whose series are ready, in request order; with `wait`, first
+ * waits for all of them. Superseded requests are dropped silently.
+ */
+void MerkelMain::showFinishedCharts(bool wait)
+{
+    auto it = pendingCharts.begin();
+    while (it != pendingCharts.end()) {
+        if (!wait && it->wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        try {
+            if (auto draw = it->get()) {
+                (*draw)();
+            }
+        } catch (const std::exception& e) {
+            std::cout << "Chart failed: " << e.what() << "\n";
+        }
+        it = pendingCharts.erase(it);
+    }
+}
+
+void MerkelMain::printStats()
+{
+    // Call counts and latencies of the load/query/match/settle paths (instrumented builds)
+    std::cout << Metrics::report();
 }
@@ -1,11 +1,20 @@
 #pragma once
 
 #include <QObject>
+#include <QPointer>
+#include <functional>
+#include <future>
+#include <optional>
 #include <vector>
 #include <string>
 
 #include "OrderBook.h"    // full definition now available
 #include "Wallet.h"       // full definition now available
+#include "Simulation.h"
+#include "AnalyticsWorker.h"
+#include "OrderBookVersions.h"
+
+class ChartWidget;
 /**
  * MerkelMain: The main CLI controller for your text‐based exchange simulation.
  *   - Offers a menu of options (help, stats, make ask, make bid, wallet, next timeframe,
@@ -45,10 +54,22 @@ private:
     void printVolumeChart();// TASK 3a: Volume chart
     void printMeanPriceChart(); // TASK 2: Mean price chart (per minute)
     void printTradesPerProduct();// TASK 4: Print number of trades per product
+    void printStats();          // Instrumentation counters and timers
+    void exploreChart();        // Zoom / pan over a chart's level-of-detail pyramid
+    void openChartWindow();     // Native chart, extended on every Continue
 
 private:
+    // Charts are computed by `analytics` and drawn on this thread once ready
+    using ChartDraw = std::function<void()>;
+    void submitChart(const std::string& channel, std::function<ChartDraw()> job);
+    void showFinishedCharts(bool wait);
+
     OrderBook&              orderBook;
     Wallet&                 wallet;
     std::vector<std::string> products;
-    std::string             currentTime;
+    Simulation              sim;          // current time, order entry and matching
+    QPointer<ChartWidget>   chartWindow;  // open chart window, if any (null once closed)
+    OrderBookVersions       versions;     // published copies of orderBook for analytics jobs
+    std::vector<std::future<std::optional<ChartDraw>>> pendingCharts;
+    AnalyticsWorker         analytics;    // declared last: stopped before the book state goes
 };
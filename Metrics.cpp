@@ -0,0 +1,237 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+/**
+ * Metrics:
+ *   Probes and counters live in deques owned by a leaked registry, so references handed
+ *   to the macros' static locals never move and stay usable during static destruction.
+ *   Each instrumented site looks its probe up once; after that a call costs two clock
+ *   reads and a few relaxed atomic adds.
+ */
+
+namespace Metrics
+{
+    namespace
+    {
+        struct Registry
+        {
+            std::mutex mutex;
+            std::deque<Probe> probes;
+            std::deque<Counter> counters;
+        };
+
+        void dumpAtExit()
+        {
+            const char* path = std::getenv("MERKEL_STATS_JSON");
+            std::ofstream out{path ? path : "merkel_stats.json"};
+            writeJson(out);
+        }
+
+        Registry& registry()
+        {
+            static Registry* instance = [] {
+                auto* r = new Registry();
+                if (enabled()) {
+                    std::atexit(dumpAtExit);
+                }
+                return r;
+            }();
+            return *instance;
+        }
+
+        /**
+         * Histogram bucket for a latency: 4 buckets per power of two, using the two bits
+         * below the leading one, so each bucket is within ~19% of its neighbours.
+         */
+        int bucketOf(std::uint64_t ns)
+        {
+            if (ns < 4) {
+                return static_cast<int>(ns);
+            }
+            int msb = std::bit_width(ns) - 1;
+            int sub = static_cast<int>((ns >> (msb - 2)) & 3);
+            int b = msb * 4 + sub - 4;
+            return b < Probe::kBuckets ? b : Probe::kBuckets - 1;
+        }
+
+        /** Smallest latency that falls in bucket `b` (inverse of bucketOf). */
+        double bucketFloor(int b)
+        {
+            if (b < 4) {
+                return b;
+            }
+            int msb = (b + 4) / 4;
+            int sub = (b + 4) % 4;
+            return std::ldexp(1.0 + sub / 4.0, msb);
+        }
+
+        std::string jsonString(const std::string& s)
+        {
+            std::string out = "\"";
+            for (char c : s) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                }
+                out += c;
+            }
+            return out + "\"";
+        }
+    }
+
+    void Probe::record(std::uint64_t ns)
+    {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        totalNs.fetch_add(ns, std::memory_order_relaxed);
+        buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t seen = maxNs.load(std::memory_order_relaxed);
+        while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * percentile
+     * Walks the histogram to the bucket holding the requested rank and returns that
+     * bucket's upper edge (capped at the largest latency seen).
+     */
+    double Probe::percentile(double fraction) const
+    {
+        std::uint64_t n = calls.load(std::memory_order_relaxed);
+        if (n == 0) {
+            return 0.0;
+        }
+        auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(n - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            seen += buckets[b].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                double edge = (b + 1 < kBuckets) ? bucketFloor(b + 1) : bucketFloor(b);
+                return std::min(edge, static_cast<double>(maxNs.load(std::memory_order_relaxed)));
+            }
+        }
+        return static_cast<double>(maxNs.load(std::memory_order_relaxed));
+    }
+
+    Probe& probe(const char* name)
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& p : r.probes) {
+            if (p.name == name) {
+                return p;
+            }
+        }
+        r.probes.emplace_back().name = name;
+        return r.probes.back();
+    }
+
+    Counter& counter(const char* name)
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& c : r.counters) {
+            if (c.name == name) {
+                return c;
+            }
+        }
+        r.counters.emplace_back().name = name;
+        return r.counters.back();
+    }
+
+    bool enabled()
+    {
+#ifdef MERKEL_INSTRUMENT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * report
+     * One row per probe (calls, total ms, mean/p99/max µs), then one per counter.
+     */
+    std::string report()
+    {
+        if (!enabled()) {
+            return "Instrumentation is compiled out (configure with -DMERKEL_INSTRUMENT=ON).\n";
+        }
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        std::ostringstream out;
+        out << std::left << std::setw(36) << "probe" << std::right
+            << std::setw(10) << "calls" << std::setw(12) << "total ms"
+            << std::setw(12) << "mean us" << std::setw(12) << "p99 us" << std::setw(12) << "max us" << "\n";
+        out << std::fixed;
+        for (const auto& p : r.probes) {
+            std::uint64_t calls = p.calls.load(std::memory_order_relaxed);
+            double total = static_cast<double>(p.totalNs.load(std::memory_order_relaxed));
+            out << std::left << std::setw(36) << p.name << std::right
+                << std::setw(10) << calls
+                << std::setw(12) << std::setprecision(2) << total / 1e6
+                << std::setw(12) << std::setprecision(2) << (calls ? total / calls / 1e3 : 0.0)
+                << std::setw(12) << std::setprecision(2) << p.percentile(0.99) / 1e3
+                << std::setw(12) << std::setprecision(2)
+                << static_cast<double>(p.maxNs.load(std::memory_order_relaxed)) / 1e3 << "\n";
+        }
+        for (const auto& c : r.counters) {
+            out << std::left << std::setw(36) << c.name << std::right
+                << std::setw(10) << c.value.load(std::memory_order_relaxed) << "\n";
+        }
+        return out.str();
+    }
+
+    void writeJson(std::ostream& out)
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        out << "{\n  \"enabled\": " << (enabled() ? "true" : "false") << ",\n  \"probes\": [";
+        const char* sep = "\n";
+        for (const auto& p : r.probes) {
+            std::uint64_t calls = p.calls.load(std::memory_order_relaxed);
+            std::uint64_t total = p.totalNs.load(std::memory_order_relaxed);
+            out << sep << "    {\"name\": " << jsonString(p.name)
+                << ", \"calls\": " << calls
+                << ", \"total_ns\": " << total
+                << ", \"mean_ns\": " << (calls ? total / calls : 0)
+                << ", \"p50_ns\": " << static_cast<std::uint64_t>(p.percentile(0.50))
+                << ", \"p99_ns\": " << static_cast<std::uint64_t>(p.percentile(0.99))
+                << ", \"max_ns\": " << p.maxNs.load(std::memory_order_relaxed) << "}";
+            sep = ",\n";
+        }
+        out << "\n  ],\n  \"counters\": {";
+        sep = "\n";
+        for (const auto& c : r.counters) {
+            out << sep << "    " << jsonString(c.name) << ": " << c.value.load(std::memory_order_relaxed);
+            sep = ",\n";
+        }
+        out << "\n  }\n}\n";
+    }
+
+    void reset()
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& p : r.probes) {
+            p.calls = 0;
+            p.totalNs = 0;
+            p.maxNs = 0;
+            for (auto& b : p.buckets) {
+                b = 0;
+            }
+        }
+        for (auto& c : r.counters) {
+            c.value = 0;
+        }
+    }
+}
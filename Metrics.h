@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * Metrics: hot-path instrumentation.
+ *   - MERKEL_TIMED_SCOPE("name") counts calls to the enclosing scope and records each
+ *     call's latency (cumulative, max and a log-scale histogram for percentiles)
+ *   - MERKEL_COUNT("name", n) adds n to a counter (bytes read, rows parsed, ...)
+ *   - Metrics::report() gives a text table; Metrics::writeJson() the same as JSON, which
+ *     is also written at exit to $MERKEL_STATS_JSON (default "merkel_stats.json")
+ * The macros compile to nothing unless MERKEL_INSTRUMENT is defined, so an ordinary
+ * build pays nothing; the report then just says instrumentation is off.
+ */
+namespace Metrics
+{
+    /** One timed scope. Updated with relaxed atomics, so probes are safe from any thread. */
+    struct Probe
+    {
+        static constexpr int kBuckets = 160;   // 4 per power of two of nanoseconds
+
+        std::string name;
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> totalNs{0};
+        std::atomic<std::uint64_t> maxNs{0};
+        std::array<std::atomic<std::uint64_t>, kBuckets> buckets{};
+
+        void record(std::uint64_t ns);
+        /** Latency (ns) below which `fraction` of the calls fell, from the histogram. */
+        double percentile(double fraction) const;
+    };
+
+    /** One running total. */
+    struct Counter
+    {
+        std::string name;
+        std::atomic<std::uint64_t> value{0};
+    };
+
+    /** The probe / counter called `name`, created on first use; the reference stays valid. */
+    Probe& probe(const char* name);
+    Counter& counter(const char* name);
+
+    /** True when the macros are compiled in. */
+    bool enabled();
+    /** Human-readable table of every probe and counter. */
+    std::string report();
+    /** {"probes": [...], "counters": {...}} with times in nanoseconds. */
+    void writeJson(std::ostream& out);
+    /** Zero every probe and counter. */
+    void reset();
+
+    /** Times its own lifetime into a probe. */
+    class ScopedTimer
+    {
+        public:
+            explicit ScopedTimer(Probe& p) : target(p), start(std::chrono::steady_clock::now()) {}
+            ~ScopedTimer()
+            {
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                target.record(static_cast<std::uint64_t>(ns));
+            }
+            ScopedTimer(const ScopedTimer&) = delete;
+            ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        private:
+            Probe& target;
+            std::chrono::steady_clock::time_point start;
+    };
+}
+
+#define MERKEL_METRICS_CAT2(a, b) a##b
+#define MERKEL_METRICS_CAT(a, b) MERKEL_METRICS_CAT2(a, b)
+
+#ifdef MERKEL_INSTRUMENT
+#define MERKEL_TIMED_SCOPE(name)                                                              \
+    static Metrics::Probe& MERKEL_METRICS_CAT(merkelProbe_, __LINE__) = Metrics::probe(name); \
+    Metrics::ScopedTimer MERKEL_METRICS_CAT(merkelTimer_, __LINE__)(MERKEL_METRICS_CAT(merkelProbe_, __LINE__))
+#define MERKEL_COUNT(name, n)                                                                 \
+    do {                                                                                      \
+        static Metrics::Counter& merkelCounter_ = Metrics::counter(name);                     \
+        merkelCounter_.value.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed); \
+    } while (0)
+#else
+#define MERKEL_TIMED_SCOPE(name) static_assert(true, "")
+#define MERKEL_COUNT(name, n) do { } while (0)
+#endif
@@ -0,0 +1,87 @@
+#include "OrderArena.h"
+#include <new>
+
+/**
+ * OrderArena:
+ *   A monotonic buffer sized for a matching timestep. Matching fills asks/bids/sales,
+ *   the caller consumes the sales, and reset() makes the whole buffer reusable again.
+ */
+
+/**
+ * Constructor
+ * @param initialBytes  Starting buffer size. It grows automatically (see reset()).
+ */
+OrderArena::OrderArena(size_t initialBytes)
+: buffer(initialBytes)
+{
+    arena.emplace(buffer.data(), buffer.size(), &upstream);
+    reset();
+}
+
+/**
+ * reset
+ * Prepares the arena for the next timestep.
+ *
+ * Behavior:
+ *   1. Destroys the asks/bids/sales vectors (nothing is freed individually; the
+ *      monotonic buffer ignores deallocation).
+ *   2. If the last timestep spilled over into the global allocator, grows the buffer
+ *      to cover that spill twice over, so a similar timestep fits next time.
+ *   3. Rewinds the monotonic buffer to its start and creates fresh vectors on it.
+ *      (pmr vectors keep their resource for life, so they are rebuilt, not reassigned.)
+ */
+void OrderArena::reset()
+{
+    askBuf.reset();
+    bidBuf.reset();
+    saleBuf.reset();
+
+    arena->release();
+    if (upstream.overflowBytes > 0) {
+        arena.reset();
+        buffer = std::vector<std::byte>(buffer.size() + 2 * upstream.overflowBytes);
+        ++bufferAllocations;
+        arena.emplace(buffer.data(), buffer.size(), &upstream);
+    }
+    upstream.overflowBytes = 0;
+
+    askBuf.emplace(&*arena);
+    bidBuf.emplace(&*arena);
+    saleBuf.emplace(&*arena);
+}
+
+/**
+ * allocationCount
+ * Total number of global allocations made by this arena: the buffer itself (once, plus
+ * once per growth) and any overflow blocks requested while a timestep did not fit.
+ */
+size_t OrderArena::allocationCount() const
+{
+    return bufferAllocations + upstream.allocations;
+}
+
+/**
+ * capacity
+ * Current size of the preallocated buffer in bytes.
+ */
+size_t OrderArena::capacity() const
+{
+    return buffer.size();
+}
+
+void* OrderArena::CountingResource::do_allocate(size_t bytes, size_t align)
+{
+    ++allocations;
+    overflowBytes += bytes;
+    return ::operator new(bytes, std::align_val_t{align});
+}
+
+void OrderArena::CountingResource::do_deallocate(void* p, size_t bytes, size_t align)
+{
+    ::operator delete(p, bytes, std::align_val_t{align});
+}
+
+bool OrderArena::CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
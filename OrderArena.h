@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory_resource>
+#include <optional>
+#include <vector>
+#include <cstddef>
+#include "OrderBookEntry.h"
+/**
+ * OrderArena: resettable scratch memory for one matching timestep.
+ *   - asks(), bids() and sales() are vectors drawing from one preallocated buffer
+ *   - reset() rewinds the buffer for the next timestep without freeing it
+ *   - if a timestep outgrew the buffer, reset() enlarges it, so later steps of the
+ *     same size make no calls to the global allocator at all
+ *   - allocationCount() reports every global allocation the arena has made
+ */
+class OrderArena
+{
+    public:
+        explicit OrderArena(size_t initialBytes = 256 * 1024);
+        OrderArena(const OrderArena&) = delete;
+        OrderArena& operator=(const OrderArena&) = delete;
+
+    /** Empty the vectors and rewind the buffer. Invalidates views of previous sales. */
+        void reset();
+    /** Global allocations so far: buffer (re)allocations plus overflow requests. */
+        size_t allocationCount() const;
+    /** Size of the preallocated buffer in bytes. */
+        size_t capacity() const;
+
+        std::pmr::vector<OrderBookEntry>& asks() { return *askBuf; }
+        std::pmr::vector<OrderBookEntry>& bids() { return *bidBuf; }
+        std::pmr::vector<OrderBookEntry>& sales() { return *saleBuf; }
+
+    private:
+    /** Upstream for the monotonic buffer: forwards to new/delete and counts requests. */
+        class CountingResource : public std::pmr::memory_resource
+        {
+            public:
+                size_t allocations = 0;
+                size_t overflowBytes = 0;  // bytes requested since the last reset
+            private:
+                void* do_allocate(size_t bytes, size_t align) override;
+                void do_deallocate(void* p, size_t bytes, size_t align) override;
+                bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+        };
+
+        CountingResource upstream;
+        std::vector<std::byte> buffer;
+        std::optional<std::pmr::monotonic_buffer_resource> arena;
+        // Declared after `arena` so they are destroyed before it
+        std::optional<std::pmr::vector<OrderBookEntry>> askBuf, bidBuf, saleBuf;
+        size_t bufferAllocations = 1;
+};
@@ -1,6 +1,10 @@
 #include "OrderBook.h"
+#include "Metrics.h"
 #include "CSVReader.h"
 #include "Candlestick.h"
+#include "Logger.h"
+#include "TaskScheduler.h"
+#include "StringPool.h"
 
 #include <vector>
 #include <string>
@@ -9,6 +13,20 @@
 #include <iostream>
 #include <cmath>
 #include <set>
+#include <array>
+#include <unordered_map>
+
+namespace {
+/**
+ * Heterogeneous "earlier than" comparison between an entry and a bare timestamp,
+ * for binary searches (lower_bound / upper_bound / equal_range) over time-sorted orders.
+ */
+struct TimestampLess
+{
+    bool operator()(const OrderBookEntry& e, std::string_view t) const { return e.timestamp < t; }
+    bool operator()(std::string_view t, const OrderBookEntry& e) const { return t < e.timestamp; }
+};
+}
 
 /**
  * OrderBook:
@@ -28,36 +46,496 @@
 
 /**
  * Constructor (two‐file overload)
- * Reads two CSV files, merges their entries into a single vector, and sorts by timestamp.
+ * Loads two CSV files as two partitions (there is no merged, fully sorted vector).
  *
  * @param file1  Path to the first CSV (e.g., "20200317.csv")
  * @param file2  Path to the second CSV (e.g., "20200601.csv")
  *
  * Behavior:
- *   1. Calls CSVReader::readCSV(file1) and CSVReader::readCSV(file2) to get two vectors.
- *   2. Reserves enough space in `orders` to hold all entries from both vectors.
- *   3. Inserts all entries from the first vector, then all entries from the second.
- *   4. Sorts the combined `orders` by ascending timestamp so that time‐based methods work correctly.
+ *   - Delegates to the file-list constructor with { file1, file2 }, which parses both
+ *     files in parallel; each is sorted only if std::is_sorted finds it out of time order.
  */
 OrderBook::OrderBook(const std::string& file1,
                      const std::string& file2)
+    : OrderBook(std::vector<std::string>{file1, file2})
 {
-    // Read in all entries from the two CSV files
-    auto march = CSVReader::readCSV(file1);
-    auto june  = CSVReader::readCSV(file2);
+}
 
-    // Preallocate the `orders` vector for efficiency
-    orders.reserve(march.size() + june.size());
+/**
+ * Constructor (file-list overload)
+ * Sets up one partition per CSV file in `files`, in parallel.
+ *
+ * @param files         Paths to the CSV files to load, in any order. Duplicates are ignored.
+ * @param mode          eager: parse every file now. lazy: only index each file's time range.
+ * @param memoryBudget  (lazy mode) max bytes of parsed partitions to keep; 0 = unlimited.
+ *
+ * Behavior:
+ *   1. Runs one TaskScheduler task per file, calling loadPartition (eager) or
+ *      indexPartition (lazy) on it; the calling thread helps while it waits.
+ *   2. Rethrows the first exception a load threw, once every load has finished.
+ *   3. Empty partitions (missing or unreadable files) are dropped and the rest are
+ *      ordered by their first timestamp (sortPartitions).
+ *   Because partitions are kept separately, a day can later be added (addFile) or
+ *   dropped (evictFile) without re-reading any other file. In lazy mode, startup only
+ *   scans each file for its time range; queries parse files on first touch.
+ */
+OrderBook::OrderBook(const std::vector<std::string>& files,
+                     LoadMode loadMode,
+                     size_t budget)
+    : mode(loadMode)
+    , memoryBudget(budget)
+{
+    // Ignore repeated file names, keeping first-seen order
+    std::vector<std::string> unique;
+    for (const auto& f : files) {
+        if (std::find(unique.begin(), unique.end(), f) == unique.end()) {
+            unique.push_back(f);
+        }
+    }
 
-    // Append all entries from March file, then from June file
-    orders.insert(orders.end(), march.begin(), march.end());
-    orders.insert(orders.end(), june.begin(),  june.end());
+    partitions.resize(unique.size());
 
-    // Sort by timestamp (lexicographically works because format is "YYYY/MM/DD HH:MM:SS")
-    std::sort(orders.begin(), orders.end(),
-        [](auto const &a, auto const &b) {
-            return a.timestamp < b.timestamp;
+    // One task per file on the shared scheduler; idle workers steal the remaining files
+    TaskGroup group;
+    for (size_t i = 0; i < unique.size(); ++i) {
+        group.run([this, &unique, i] {
+            partitions[i] = (mode == LoadMode::lazy) ? indexPartition(unique[i])
+                                                     : loadPartition(unique[i]);
         });
+    }
+    group.wait();
+
+    for (const auto& p : partitions) {
+        residentBytes += p.bytes;
+    }
+    sortPartitions();
+}
+
+/**
+ * Default constructor
+ * Creates an empty book with no partitions. Use addFile to load days into it.
+ */
+OrderBook::OrderBook()
+{
+}
+
+/**
+ * fromGlob
+ * Builds a book from every file matching `pattern`.
+ *
+ * @param pattern       A path such as "data/2020*.csv", or a directory (meaning every "*.csv" inside it).
+ * @param mode          eager or lazy loading (see the file-list constructor).
+ * @param memoryBudget  (lazy mode) max bytes of parsed partitions to keep; 0 = unlimited.
+ * @return An OrderBook holding one partition per matching file.
+ *
+ * Behavior:
+ *   - Expands the pattern with CSVReader::expandGlob, then uses the file-list constructor.
+ */
+OrderBook OrderBook::fromGlob(const std::string& pattern,
+                              LoadMode mode,
+                              size_t memoryBudget)
+{
+    return OrderBook(CSVReader::expandGlob(pattern), mode, memoryBudget);
+}
+
+/**
+ * addFile
+ * Adds one more CSV file to the book as a separate partition.
+ *
+ * @param file  Path to the CSV file (e.g., a new day's dump).
+ * @return false if a partition from `file` is already loaded, true otherwise.
+ *
+ * Behavior:
+ *   - Eager mode: reads and orders only this file (loadPartition).
+ *   - Lazy mode: only indexes its time range (indexPartition).
+ *   - Other partitions are not touched. Empty/unreadable files add nothing but still return true.
+ */
+bool OrderBook::addFile(const std::string& file)
+{
+    for (const auto& p : partitions) {
+        if (p.source == file) {
+            return false;
+        }
+    }
+    partitions.push_back((mode == LoadMode::lazy) ? indexPartition(file)
+                                                  : loadPartition(file));
+    residentBytes += partitions.back().bytes;
+    sortPartitions();
+    return true;
+}
+
+/**
+ * addOrders
+ * Adds a batch of orders that did not come from a file (e.g. generated ones) as one
+ * partition labelled `source`.
+ *
+ * @param source  Label for the partition, listed by getLoadedFiles() and accepted by evictFile().
+ * @param orders  The orders; sorted here if they are not already in time order.
+ * @return false if a partition with that label is already loaded, true otherwise.
+ *
+ * Behavior:
+ *   - The partition is pinned: with no file to re-read it from, the memory budget
+ *     never evicts it (evictFile still drops it). Its bytes count as resident.
+ */
+bool OrderBook::addOrders(const std::string& source, std::vector<OrderBookEntry> orders)
+{
+    for (const auto& p : partitions) {
+        if (p.source == source) {
+            return false;
+        }
+    }
+    Partition p;
+    p.source = source;
+    p.pinned = true;
+    finishPartition(p, std::move(orders));
+    residentBytes += p.bytes;
+    partitions.push_back(std::move(p));
+    sortPartitions();
+    return true;
+}
+
+/**
+ * evictFile
+ * Removes the partition that was loaded from `file`, freeing its orders.
+ *
+ * @param file  The same path that was used to load it.
+ * @return true if a partition was removed, false if no such file was loaded.
+ */
+bool OrderBook::evictFile(const std::string& file)
+{
+    auto it = std::find_if(partitions.begin(), partitions.end(),
+                           [&](const Partition& p) { return p.source == file; });
+    if (it == partitions.end()) {
+        return false;
+    }
+    residentBytes -= it->bytes;
+    partitions.erase(it);
+    return true;
+}
+
+/**
+ * getLoadedFiles
+ * Lists the source file of every file-backed partition, in time order.
+ * (The partition holding user-entered orders has no file and is not listed.)
+ */
+std::vector<std::string> OrderBook::getLoadedFiles()
+{
+    std::vector<std::string> files;
+    for (const auto& p : partitions) {
+        if (!p.source.empty()) {
+            files.push_back(p.source);
+        }
+    }
+    return files;
+}
+
+/**
+ * getResidentBytes
+ * Returns the approximate memory held by parsed file partitions. In lazy mode with a
+ * budget this stays at or under the budget (plus the partition currently in use).
+ */
+size_t OrderBook::getResidentBytes() const
+{
+    return residentBytes;
+}
+
+/**
+ * loadPartition
+ * Reads one CSV file and returns it as a parsed partition sorted by timestamp.
+ *
+ * @param file  Path to the CSV file.
+ * @return The partition (its `orders` may be empty if the file could not be read).
+ */
+OrderBook::Partition OrderBook::loadPartition(const std::string& file)
+{
+    Partition p;
+    p.source = file;
+    parsePartition(p);
+    return p;
+}
+
+/**
+ * indexPartition
+ * Creates an unparsed partition for `file`, recording only its time range.
+ *
+ * @param file  Path to the CSV file.
+ * @return A partition with `loaded == false`, or an empty one if the file has no valid rows.
+ *
+ * Behavior:
+ *   - Uses CSVReader::readTimeRange, which scans every row's timestamp for the earliest
+ *     and latest, so the range covers the file even when its rows are out of time order
+ *     (queries would otherwise skip the partition for timestamps outside it).
+ */
+OrderBook::Partition OrderBook::indexPartition(const std::string& file)
+{
+    Partition p;
+    p.source = file;
+    CSVReader::readTimeRange(file, p.first, p.last);
+    return p;
+}
+
+/**
+ * parsePartition
+ * Reads the partition's file into `p.orders` and fills in its range and size.
+ *
+ * @param p  A partition with `source` set.
+ *
+ * Behavior:
+ *   1. Calls CSVReader::readCSV(p.source).
+ *   2. Checks the rows with std::is_sorted (O(n)). Exchange dumps are almost always
+ *      already in time order, so this normally passes and nothing is sorted.
+ *   3. Only if the file is out of order, sorts it with parallelSortByTimestamp.
+ *   4. Sets first/last from the sorted data and records `bytes` (the vector storage;
+ *      entry strings live in the shared StringPool, not in the partition).
+ *   5. Records the distinct products, which stay known after the partition is evicted.
+ */
+void OrderBook::parsePartition(Partition& p)
+{
+    MERKEL_TIMED_SCOPE("OrderBook::parsePartition");
+    finishPartition(p, CSVReader::readCSV(p.source));
+}
+
+/**
+ * finishPartition
+ * Brings freshly read orders into time order, makes them the partition's orders
+ * (a store of their own, which nothing appends to) and records the partition's range, size and product list.
+ *
+ * @param p       The partition being filled.
+ * @param orders  Its orders, just read or handed over.
+ */
+void OrderBook::finishPartition(Partition& p, std::vector<OrderBookEntry> orders)
+{
+    // Fall back to sorting only when the orders are not already in time order
+    if (!std::is_sorted(orders.begin(), orders.end(), OrderBookEntry::compareByTimestamp)) {
+        parallelSortByTimestamp(orders);
+    }
+
+    p.loaded = true;
+    p.bytes  = orders.capacity() * sizeof(OrderBookEntry);
+    p.orders = std::make_shared<OrderStore>();
+    p.orders->entries = std::move(orders);
+    p.count = p.orders->entries.size();
+    p.orders->claimed = p.count;
+    const auto& sorted = p.orders->entries;
+    if (sorted.empty()) {
+        return;
+    }
+    p.first = sorted.front().timestamp;
+    p.last  = sorted.back().timestamp;
+
+    std::set<std::string_view> seen;
+    for (const auto& e : sorted) {
+        seen.insert(e.product);
+    }
+
+    p.products.assign(seen.begin(), seen.end());
+    p.productsKnown = true;
+}
+
+/**
+ * acquire
+ * Returns the orders of a partition, parsing it first if it is not in memory.
+ *
+ * @param p  A partition of this book.
+ * @return The first p.count entries of p.orders, valid until the next call that may
+ *         evict (another acquire).
+ *
+ * Behavior:
+ *   - If `p` is not loaded, parses it (parsePartition) and adds its size to residentBytes.
+ *   - Stamps `p` with the next LRU clock value.
+ *   - Calls enforceBudget so other cold partitions are evicted if we are now over budget.
+ */
+std::span<const OrderBookEntry> OrderBook::acquire(Partition& p)
+{
+    if (!p.loaded) {
+        parsePartition(p);
+        residentBytes += p.bytes;
+    }
+    p.lastUse = ++useClock;
+    enforceBudget(&p);
+    if (!p.orders) {
+        return {};
+    }
+    // Not entries.size(): another copy of the book may be appending past `count`
+    return std::span<const OrderBookEntry>(p.orders->entries.data(), p.count);
+}
+
+/**
+ * enforceBudget
+ * Evicts parsed file partitions, least recently used first, until the book is back
+ * under its memory budget.
+ *
+ * @param keep  A partition that must stay resident (the one being used right now), or nullptr.
+ *
+ * Behavior:
+ *   - Does nothing in eager mode or when the budget is 0 (unlimited).
+ *   - Never evicts the user-order partition (empty `source`): it has no file to reload from.
+ *   - An evicted partition keeps its source and time range, so it is re-parsed on next touch.
+ */
+void OrderBook::enforceBudget(const Partition* keep)
+{
+    if (mode != LoadMode::lazy || memoryBudget == 0) {
+        return;
+    }
+
+    while (residentBytes > memoryBudget) {
+        Partition* victim = nullptr;
+        for (auto& p : partitions) {
+            if (p.loaded && !p.pinned && !p.source.empty() && &p != keep &&
+                (victim == nullptr || p.lastUse < victim->lastUse))
+            {
+                victim = &p;
+            }
+        }
+        if (victim == nullptr) {
+            return;   // only `keep` (or nothing evictable) is resident
+        }
+
+        residentBytes -= victim->bytes;
+        victim->bytes  = 0;
+        victim->loaded = false;
+        victim->orders.reset();   // freed once no snapshot shares it
+        victim->count  = 0;
+    }
+}
+
+/**
+ * sortPartitions
+ * Drops partitions with no data and orders the rest by their first timestamp, so that
+ * partitions.front() normally holds the earliest order in the book.
+ * (Queries do not rely on this order for correctness: a lazily indexed range can shift
+ * slightly once the partition is parsed.)
+ */
+void OrderBook::sortPartitions()
+{
+    partitions.erase(std::remove_if(partitions.begin(), partitions.end(),
+                                    [](const Partition& p) { return p.first.empty(); }),
+                     partitions.end());
+    std::stable_sort(partitions.begin(), partitions.end(),
+                     [](const Partition& a, const Partition& b) {
+                         return a.firstTime() < b.firstTime();
+                     });
+}
+
+/**
+ * mergeSortedRuns
+ * k-way merges runs that are each sorted by timestamp into a single sorted vector.
+ *
+ * @param runs  The sorted runs. Their entries are moved out; the runs are left empty.
+ * @return One vector containing every entry of every run, sorted by timestamp.
+ *
+ * Behavior:
+ *   - 0 runs: returns an empty vector. 1 run: returns it as-is (no copy).
+ *   - Otherwise keeps a min-heap holding the index of each non-exhausted run, ordered by
+ *     the timestamp at that run's read position (ties go to the lower run index, so the
+ *     merge is stable). Repeatedly moves the smallest head entry into the output.
+ *   - Cost: O(n log k) timestamp comparisons for n entries across k runs.
+ */
+std::vector<OrderBookEntry> OrderBook::mergeSortedRuns(
+    std::vector<std::vector<OrderBookEntry>>& runs)
+{
+    // Drop empty runs so the heap only ever holds runs with a valid head
+    runs.erase(std::remove_if(runs.begin(), runs.end(),
+                              [](const auto& run) { return run.empty(); }),
+               runs.end());
+
+    if (runs.empty()) {
+        return {};
+    }
+    if (runs.size() == 1) {
+        return std::move(runs.front());
+    }
+
+    size_t total = 0;
+    for (const auto& run : runs) {
+        total += run.size();
+    }
+
+    std::vector<OrderBookEntry> merged;
+    merged.reserve(total);
+
+    // Read position inside each run
+    std::vector<size_t> pos(runs.size(), 0);
+
+    // "a comes after b" ordering, so std::*_heap keeps the earliest head on top
+    auto later = [&](size_t a, size_t b) {
+        std::string_view ta = runs[a][pos[a]].timestamp;
+        std::string_view tb = runs[b][pos[b]].timestamp;
+        if (ta != tb) {
+            return ta > tb;
+        }
+        return a > b;
+    };
+
+    std::vector<size_t> heap(runs.size());
+    for (size_t i = 0; i < runs.size(); ++i) {
+        heap[i] = i;
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    while (!heap.empty()) {
+        // Take the run with the earliest head off the heap
+        std::pop_heap(heap.begin(), heap.end(), later);
+        size_t r = heap.back();
+
+        merged.push_back(std::move(runs[r][pos[r]]));
+        ++pos[r];
+
+        if (pos[r] < runs[r].size()) {
+            // Run still has entries: put it back with its new head
+            std::push_heap(heap.begin(), heap.end(), later);
+        } else {
+            heap.pop_back();
+            runs[r].clear();
+        }
+    }
+
+    return merged;
+}
+
+/**
+ * parallelSortByTimestamp
+ * Sorts a single out-of-order run by timestamp using every available core.
+ *
+ * @param run  The entries to sort in place.
+ *
+ * Behavior:
+ *   1. Splits `run` into one contiguous chunk per scheduler worker (at least 1).
+ *      Small runs are sorted directly on the calling thread.
+ *   2. Sorts each chunk with std::sort as a TaskScheduler task.
+ *   3. k-way merges the sorted chunks back into `run` with mergeSortedRuns.
+ */
+void OrderBook::parallelSortByTimestamp(std::vector<OrderBookEntry>& run)
+{
+    const size_t MIN_CHUNK = 1 << 14;   // below this, threading costs more than it saves
+    size_t threads = TaskScheduler::shared().workerCount();
+    threads = std::min(threads, std::max<size_t>(1, run.size() / MIN_CHUNK));
+
+    if (threads == 1) {
+        std::sort(run.begin(), run.end(), OrderBookEntry::compareByTimestamp);
+        return;
+    }
+
+    // 1) Move each contiguous slice of `run` into its own chunk
+    std::vector<std::vector<OrderBookEntry>> chunks(threads);
+    size_t per = run.size() / threads;
+    for (size_t t = 0; t < threads; ++t) {
+        auto first = run.begin() + t * per;
+        auto last  = (t + 1 == threads) ? run.end() : first + per;
+        chunks[t].assign(std::make_move_iterator(first), std::make_move_iterator(last));
+    }
+
+    // 2) Sort the chunks concurrently
+    TaskGroup group;
+    for (auto& chunk : chunks) {
+        group.run([&chunk] {
+            std::sort(chunk.begin(), chunk.end(), OrderBookEntry::compareByTimestamp);
+        });
+    }
+    group.wait();
+
+    // 3) Merge the sorted chunks back together
+    run = mergeSortedRuns(chunks);
 }
 
 /**
@@ -65,22 +543,51 @@ OrderBook::OrderBook(const std::string& file1,
  * Returns a vector of every distinct product string found in `orders`.
  *
  * Behavior:
- *   1. Iterates all OrderBookEntry in `orders` and inserts `e.product` into a map (or set) to dedupe.
- *   2. Flattens the map keys into a vector<string> and returns it.
+ *   1. Each file partition records its products when it is parsed and keeps them after
+ *      eviction, so only files that were never parsed (lazy mode) are read here, once.
+ *      Those are parsed in parallel, one TaskScheduler task per file, a batch of one
+ *      file per worker at a time; the memory budget is enforced after every batch.
+ *   2. Inserts every partition's product list into a map to dedupe.
+ *   3. Flattens the map keys into a vector<string> and returns it.
  *
  * @return Vector<string> of unique product names (e.g., "BTC/USDT", "ETH/BTC", etc.)
  */
 std::vector<std::string> OrderBook::getKnownProducts()
 {
+    MERKEL_TIMED_SCOPE("OrderBook::getKnownProducts");
     std::vector<std::string> products;
     std::map<std::string,bool> prodMap; // maps product name to a dummy bool
 
-    // Mark each product as "seen"
-    for (OrderBookEntry& e : orders) {
-        prodMap[e.product] = true;
+    // 1) Parse the files whose products are not known yet
+    std::vector<Partition*> unknown;
+    for (auto& p : partitions) {
+        if (!p.productsKnown && !p.loaded) {
+            unknown.push_back(&p);
+        }
+    }
+    const size_t batch = TaskScheduler::shared().workerCount();
+    for (size_t first = 0; first < unknown.size(); first += batch) {
+        size_t last = std::min(unknown.size(), first + batch);
+        TaskGroup group;
+        for (size_t i = first; i < last; ++i) {
+            group.run([p = unknown[i]] { parsePartition(*p); });   // touches only *p
+        }
+        group.wait();
+        for (size_t i = first; i < last; ++i) {
+            residentBytes += unknown[i]->bytes;
+            unknown[i]->lastUse = ++useClock;
+        }
+        enforceBudget(nullptr);
     }
 
-    // Extract keys (product names) into a vector
+    // 2) Mark each product as "seen"
+    for (const auto& p : partitions) {
+        for (const auto& product : p.products) {
+            prodMap[product] = true;
+        }
+    }
+
+    // 3) Extract keys (product names) into a vector
     for (auto const& pair : prodMap) {
         products.push_back(pair.first);
     }
@@ -88,6 +595,159 @@ std::vector<std::string> OrderBook::getKnownProducts()
     return products;
 }
 
+/**
+ * collectOrders
+ * Appends to `out` every order that matches a side, product and exact timestamp.
+ * Shared by getOrders (std::vector) and matching (arena-backed std::pmr::vector).
+ *
+ * Behavior:
+ *   - Visits only partitions whose [first, last] time range contains `timestamp`,
+ *     parsing them first if needed (acquire).
+ *   - In each, binary-searches (equal_range) the block of entries with that timestamp.
+ *   - If an entry’s orderType and product also match, appends it to `out`.
+ */
+template <typename Vector>
+void OrderBook::collectOrders(OrderBookType type,
+                              std::string_view product,
+                              std::string_view timestamp,
+                              Vector& out)
+{
+    for (auto& p : partitions) {
+        if (timestamp < p.firstTime() || p.lastTime() < timestamp) {
+            continue;  // this partition cannot hold the timestamp
+        }
+        std::span<const OrderBookEntry> entries = acquire(p);
+        auto [first, last] = std::equal_range(entries.begin(), entries.end(),
+                                              timestamp, TimestampLess{});
+        for (auto it = first; it != last; ++it) {
+            if (it->orderType == type &&
+                it->product   == product)
+            {
+                out.push_back(*it);
+            }
+        }
+    }
+}
+
+/**
+ * TimestampTotals
+ * The matching orders of one timestamp, reduced to what candles and volume need.
+ * `orders == 0` records a timestamp of the book at which nothing matched.
+ */
+struct OrderBook::TimestampTotals
+{
+    std::string_view timestamp;   // pooled
+    size_t orders = 0;
+    double high = 0.0;
+    double low = 0.0;
+    double value = 0.0;           // ∑ price * amount
+    double amount = 0.0;          // ∑ amount
+
+    void add(const OrderBookEntry& e)
+    {
+        high = (orders == 0) ? e.price : std::max(high, e.price);
+        low  = (orders == 0) ? e.price : std::min(low, e.price);
+        value  += e.price * e.amount;
+        amount += e.amount;
+        ++orders;
+    }
+};
+
+/**
+ * overlaps
+ * Whether partition `p` can hold a timestamp in [from, to) (empty `to`: no upper bound),
+ * judged from its recorded range, so unparsed partitions outside the range stay unparsed.
+ */
+bool OrderBook::overlaps(const Partition& p, std::string_view from, std::string_view to)
+{
+    return !(p.lastTime() < from) && (to.empty() || std::string_view(p.firstTime()) < to);
+}
+
+/**
+ * sliceOf
+ * The orders of `p` with a timestamp in [from, to), found by binary search
+ * (lower_bound on both ends) in the time-sorted partition.
+ *
+ * @return A view valid until the next call that may evict (another acquire).
+ */
+std::span<const OrderBookEntry> OrderBook::sliceOf(Partition& p, std::string_view from, std::string_view to)
+{
+    std::span<const OrderBookEntry> entries = acquire(p);
+    auto first = std::lower_bound(entries.begin(), entries.end(), from, TimestampLess{});
+    auto last  = to.empty() ? entries.end()
+                            : std::lower_bound(first, entries.end(), to, TimestampLess{});
+    return std::span<const OrderBookEntry>(entries.data() + (first - entries.begin()),
+                                           static_cast<size_t>(last - first));
+}
+
+/**
+ * totalsPerTimestamp
+ * One TimestampTotals per distinct timestamp in [from, to), ascending, covering the
+ * orders that match side/product.
+ *
+ * Behavior:
+ *   - Skips partitions whose range misses [from, to) and binary-searches the rest
+ *     (sliceOf), so the cost follows the size of the window, not of the book.
+ *   - Walks each slice once, starting new totals whenever the timestamp changes.
+ *   - Partitions usually cover disjoint days, so each slice simply appends; one that
+ *     overlaps what has been collected so far (the user's orders do) is merged in,
+ *     entry by entry, so each timestamp is summed partition by partition, in order.
+ */
+std::vector<OrderBook::TimestampTotals> OrderBook::totalsPerTimestamp(
+    OrderBookType side,
+    std::string_view product,
+    std::string_view from,
+    std::string_view to)
+{
+    std::vector<TimestampTotals> totals;
+
+    for (auto& p : partitions) {
+        if (!overlaps(p, from, to)) {
+            continue;
+        }
+        std::span<const OrderBookEntry> slice = sliceOf(p, from, to);
+        if (slice.empty()) {
+            continue;
+        }
+        auto matches = [&](const OrderBookEntry& e) { return e.orderType == side && e.product == product; };
+
+        if (totals.empty() || totals.back().timestamp < slice.front().timestamp) {
+            for (const auto& e : slice) {
+                if (totals.empty() || totals.back().timestamp != e.timestamp) {
+                    totals.emplace_back().timestamp = e.timestamp;
+                }
+                if (matches(e)) {
+                    totals.back().add(e);
+                }
+            }
+            continue;
+        }
+
+        // Overlap: merge, adding each entry to the totals of its timestamp in turn
+        std::vector<TimestampTotals> merged;
+        merged.reserve(totals.size() + slice.size());
+        auto a = totals.begin();
+        for (const auto& e : slice) {
+            while (a != totals.end() && a->timestamp < e.timestamp) {
+                merged.push_back(*a++);
+            }
+            if (merged.empty() || merged.back().timestamp != e.timestamp) {
+                if (a != totals.end() && a->timestamp == e.timestamp) {
+                    merged.push_back(*a++);
+                } else {
+                    merged.emplace_back().timestamp = e.timestamp;
+                }
+            }
+            if (matches(e)) {
+                merged.back().add(e);
+            }
+        }
+        merged.insert(merged.end(), a, totals.end());
+        totals = std::move(merged);
+    }
+    return totals;
+}
+
 /**
  * getOrders
  * Retrieves all orders that match a given side, product, and exact timestamp.
@@ -99,23 +759,16 @@ std::vector<std::string> OrderBook::getKnownProducts()
  * @return A vector<OrderBookEntry> containing all matching orders; may be empty.
  *
  * Behavior:
- *   - Iterates through the entire `orders` vector.
- *   - If an entry’s orderType, product, and timestamp all match, add it to the result.
+ *   - Collects the matches with collectOrders into a fresh vector.
  */
 std::vector<OrderBookEntry> OrderBook::getOrders(
     OrderBookType type,
-    std::string product,
-    std::string timestamp)
+    const std::string& product,
+    const std::string& timestamp)
 {
+    MERKEL_TIMED_SCOPE("OrderBook::getOrders");
     std::vector<OrderBookEntry> orders_sub;
-    for (OrderBookEntry& e : orders) {
-        if (e.orderType == type &&
-            e.product   == product &&
-            e.timestamp == timestamp)
-        {
-            orders_sub.push_back(e);
-        }
-    }
+    collectOrders(type, product, timestamp, orders_sub);
     return orders_sub;
 }
 
@@ -130,11 +783,11 @@ std::vector<OrderBookEntry> OrderBook::getOrders(
  *   - Start with orders[0].price as initial max.
  *   - Iterate through all entries, update max if e.price > current max.
  */
-double OrderBook::getHighPrice(std::vector<OrderBookEntry>& orders)
+double OrderBook::getHighPrice(const std::vector<OrderBookEntry>& orders)
 {
     // Assume orders is nonempty
     double maxPrice = orders[0].price;
-    for (OrderBookEntry& e : orders) {
+    for (const OrderBookEntry& e : orders) {
         if (e.price > maxPrice) {
             maxPrice = e.price;
         }
@@ -153,11 +806,11 @@ double OrderBook::getHighPrice(std::vector<OrderBookEntry>& orders)
  *   - Start with orders[0].price as initial min.
  *   - Iterate through all entries, update min if e.price < current min.
  */
-double OrderBook::getLowPrice(std::vector<OrderBookEntry>& orders)
+double OrderBook::getLowPrice(const std::vector<OrderBookEntry>& orders)
 {
     // Assume orders is nonempty
     double minPrice = orders[0].price;
-    for (OrderBookEntry& e : orders) {
+    for (const OrderBookEntry& e : orders) {
         if (e.price < minPrice) {
             minPrice = e.price;
         }
@@ -171,62 +824,56 @@ double OrderBook::getLowPrice(std::vector<OrderBookEntry>& orders)
  *
  * @param side     Which side to consider (OrderBookType::ask or ::bid)
  * @param product  The product to process (e.g., "ETH/USDT")
+ * @param from     First timestamp to include ("" = from the start).
+ * @param to       First timestamp to leave out ("" = to the end).
  *
- * @return A vector<Candlestick> containing one Candlestick per unique timestamp
- *         (that has at least one order on the given side/product).
+ * @return A vector<Candlestick> containing one Candlestick per unique timestamp in
+ *         [from, to) (that has at least one order on the given side/product).
  *
  * Behavior:
- *   1. Calls CSVReader::getAllTimestamps() to obtain a sorted vector<string> of all timestamps.
- *   2. Iterates each timestamp `ts` in ascending order:
- *        a. Calls getOrders(side, product, ts) to fetch all matching OrderBookEntry.
- *        b. If no entries, skip to next timestamp.
- *        c. Compute high = getHighPrice(entries), low = getLowPrice(entries).
- *        d. Compute VWAP‐style close = (∑(price*amount)) / (∑ amount).
- *        e. Determine open price:
+ *   1. Calls totalsPerTimestamp to get, for every timestamp in the range in ascending
+ *      order, the count, high, low, ∑(price*amount) and ∑amount of the matching orders.
+ *      Only the part of each partition inside [from, to) is read.
+ *   2. Iterates the totals in ascending order:
+ *        a. If a timestamp has no matching orders, skip it.
+ *        b. high/low are the totals' high/low.
+ *        c. Compute VWAP‐style close = (∑(price*amount)) / (∑ amount).
+ *        d. Determine open price:
  *             - If `candles` is empty (first candle), open = close.
  *             - Otherwise open = previous candle’s close.
- *        f. Append Candlestick(ts, open, high, low, close) to result.
- *        g. Set prevClose = close.
+ *        e. Append Candlestick(ts, open, high, low, close) to result.
+ *        f. Set prevClose = close.
  *   3. Return the `candles` vector.
  */
 std::vector<Candlestick> OrderBook::getCandlestickData(
     OrderBookType side,
-    const std::string& product)
+    const std::string& product,
+    const std::string& from,
+    const std::string& to)
 {
+    MERKEL_TIMED_SCOPE("OrderBook::getCandlestickData");
     std::vector<Candlestick> candles;
 
-    // 1) Get all timestamps (sorted ascending, from CSVReader)
-    auto times = CSVReader::getAllTimestamps();
+    // 1) Per-timestamp totals over the range (sorted ascending)
+    auto totals = totalsPerTimestamp(side, product, from, to);
 
     // Track the previous close price so that open = previousClose
     double prevClose = 0.0;
 
     // 2) For each timestamp in ascending order
-    for (const auto& ts : times) {
-        // 2a) Fetch all orders for this side/product/timestamp
-        auto entries = getOrders(side, product, ts);
-        if (entries.empty()) {
+    for (const auto& t : totals) {
+        if (t.orders == 0) {
             continue;  // No orders at this timestamp; skip
         }
 
-        // 2b) Compute high and low among the entries
-        double high = getHighPrice(entries);
-        double low  = getLowPrice(entries);
-
-        // 2c) Compute VWAP-style close (weighted average by amount)
-        double totVal = 0.0;
-        double totAmt = 0.0;
-        for (auto& e : entries) {
-            totVal += e.price * e.amount;
-            totAmt += e.amount;
-        }
-        double close = totVal / totAmt;
+        // 2c) VWAP-style close (weighted average by amount)
+        double close = t.value / t.amount;
 
         // 2d) Compute open price: previous candle’s close, or equal to close if first candle
         double open = candles.empty() ? close : prevClose;
 
         // 2e) Add this new Candlestick to the vector
-        candles.emplace_back(ts, open, high, low, close);
+        candles.emplace_back(std::string(t.timestamp), open, t.high, t.low, close);
 
         // 2f) Update prevClose for next iteration
         prevClose = close;
@@ -241,40 +888,33 @@ std::vector<Candlestick> OrderBook::getCandlestickData(
  *
  * @param side     Which side to consider (ask or bid)
  * @param product  The product (e.g., "ETH/USDT")
+ * @param from     First timestamp to include ("" = from the start).
+ * @param to       First timestamp to leave out ("" = to the end).
  *
- * @return A vector of (timestamp, totalAmount) pairs, where `totalAmount`
- *         is the sum of all e.amount for entries matching side/product at that timestamp.
+ * @return A vector of (timestamp, totalAmount) pairs, one for every timestamp of the
+ *         book in [from, to), where `totalAmount` is the sum of all e.amount for
+ *         entries matching side/product at that timestamp (0 if there are none).
  *
  * Behavior:
- *   1. Calls CSVReader::getAllTimestamps() to get a sorted list of all timestamps.
- *   2. For each timestamp `ts`:
- *        a. Calls getOrders(side, product, ts) to fetch matching entries.
- *        b. Sums up entry.amount for all these entries.
- *        c. Pushes (ts, totalAmt) into the result vector.
- *   3. Returns the vector of (timestamp, totalAmt) pairs.
+ *   1. Calls totalsPerTimestamp for the range (only that slice of each partition is read).
+ *   2. Pushes (ts, ∑amount) for each timestamp into the result vector, in order.
  */
 std::vector<std::pair<std::string, double>> OrderBook::getVolumeData(
     OrderBookType side,
-    const std::string& product)
+    const std::string& product,
+    const std::string& from,
+    const std::string& to)
 {
+    MERKEL_TIMED_SCOPE("OrderBook::getVolumeData");
     std::vector<std::pair<std::string, double>> volumeSeries;
 
-    // 1) Get all timestamps
-    auto times = CSVReader::getAllTimestamps();
+    // 1) Per-timestamp totals over the range
+    auto totals = totalsPerTimestamp(side, product, from, to);
 
-    // 2) Compute total volume per timestamp
-    for (const auto& ts : times) {
-        // 2a) Fetch all orders for this side/product/timestamp
-        auto entries = getOrders(side, product, ts);
-
-        // 2b) Sum up the amounts
-        double totalAmt = 0.0;
-        for (auto& e : entries) {
-            totalAmt += e.amount;
-        }
-
-        // 2c) Record the (timestamp, totalAmt) pair
-        volumeSeries.emplace_back(ts, totalAmt);
+    // 2) Record the (timestamp, totalAmt) pairs
+    volumeSeries.reserve(totals.size());
+    for (const auto& t : totals) {
+        volumeSeries.emplace_back(std::string(t.timestamp), t.amount);
     }
 
     return volumeSeries;
@@ -284,67 +924,225 @@ std::vector<std::pair<std::string, double>> OrderBook::getVolumeData(
  * getEarliestTime
  * Returns the earliest timestamp among all orders.
  *
- * @return The timestamp string of the first (oldest) order in `orders`.
- *         Assumes `orders` is nonempty and already sorted by timestamp.
+ * @return The timestamp string of the first (oldest) order in the book,
+ *         or an empty string if the book is empty.
  */
 std::string OrderBook::getEarliestTime()
 {
-    // Since `orders` was sorted in the constructor, the first element is earliest
-    return orders[0].timestamp;
+    // Every partition knows its first timestamp without being parsed
+    std::string earliest;
+    for (const auto& p : partitions) {
+        if (earliest.empty() || p.firstTime() < earliest) {
+            earliest = p.firstTime();
+        }
+    }
+    return earliest;
 }
 
 /**
  * getNextTime
- * Given a current timestamp, finds the next‐greater timestamp in `orders`.
+ * Given a current timestamp, finds the next‐greater timestamp in the book.
  * If none exists (i.e., we were at the last timestamp), wrap around to the earliest.
  *
  * @param timestamp  The current timestamp string ("YYYY/MM/DD HH:MM:SS")
  * @return The next timestamp in ascending order, or the earliest timestamp if at the end.
  *
  * Behavior:
- *   - Iterate through `orders` in ascending order.
- *   - As soon as an entry’s timestamp > the given `timestamp`, return that timestamp.
- *   - If no such entry is found, return `orders[0].timestamp` (wrap around).
+ *   - A partition that starts after `timestamp` offers its first timestamp (no parsing).
+ *   - A partition whose range spans `timestamp` is acquired and binary-searched
+ *     (upper_bound) for the first entry strictly later than it.
+ *   - Returns the smallest such timestamp over all partitions.
+ *   - If no such entry is found, returns getEarliestTime() (wrap around).
  */
-std::string OrderBook::getNextTime(std::string timestamp)
+std::string OrderBook::getNextTime(const std::string& timestamp)
 {
-    std::string next_timestamp = "";
+    MERKEL_TIMED_SCOPE("OrderBook::getNextTime");
+    std::string next;
 
-    // Search for the first order whose timestamp is strictly greater
-    for (OrderBookEntry& e : orders) {
-        if (e.timestamp > timestamp) {
-            next_timestamp = e.timestamp;
-            break;
+    for (auto& p : partitions) {
+        if (p.lastTime() <= timestamp) {
+            continue;  // everything in this partition is at or before `timestamp`
+        }
+        std::string candidate;
+        if (timestamp < p.firstTime()) {
+            candidate = p.firstTime();
+        } else {
+            std::span<const OrderBookEntry> entries = acquire(p);
+            auto it = std::upper_bound(entries.begin(), entries.end(),
+                                       timestamp, TimestampLess{});
+            if (it == entries.end()) {
+                continue;  // range was an estimate; nothing later in here after all
+            }
+            candidate = it->timestamp;
+        }
+        if (next.empty() || candidate < next) {
+            next = candidate;
         }
     }
 
     // If none found, wrap around to earliest timestamp
-    if (next_timestamp.empty()) {
-        next_timestamp = orders[0].timestamp;
+    if (next.empty()) {
+        return getEarliestTime();
     }
+    return next;
+}
+
+/**
+ * getAllTimestamps
+ * Collects every distinct timestamp in the book, in ascending order.
+ *
+ * @return A sorted vector of unique timestamp strings.
+ *
+ * Behavior:
+ *   - Acquires and walks each (time-sorted) partition, keeping a timestamp only when it differs from
+ *     the previous one, so each partition yields a sorted, duplicate-free list.
+ *   - Partitions usually cover disjoint days, so each list is simply appended; if one
+ *     overlaps what has been collected so far, the two lists are merged with std::set_union.
+ */
+std::vector<std::string> OrderBook::getAllTimestamps()
+{
+    MERKEL_TIMED_SCOPE("OrderBook::getAllTimestamps");
+    std::vector<std::string> times;
+
+    for (auto& p : partitions) {
+        std::vector<std::string> part;
+        for (const auto& e : acquire(p)) {
+            if (part.empty() || part.back() != e.timestamp) {
+                part.emplace_back(e.timestamp);
+            }
+        }
+        if (part.empty()) {
+            continue;
+        }
 
-    return next_timestamp;
+        if (times.empty() || times.back() < part.front()) {
+            times.insert(times.end(),
+                         std::make_move_iterator(part.begin()),
+                         std::make_move_iterator(part.end()));
+        } else {
+            std::vector<std::string> merged;
+            merged.reserve(times.size() + part.size());
+            std::set_union(times.begin(), times.end(), part.begin(), part.end(),
+                           std::back_inserter(merged));
+            times = std::move(merged);
+        }
+    }
+    return times;
 }
 
 /**
  * insertOrder
- * Inserts a new OrderBookEntry into `orders` and re‐sorts by timestamp so all
+ * Inserts a new OrderBookEntry into the book, keeping it sorted by timestamp so all
  * time‐based queries remain correct.
  *
  * @param order  The OrderBookEntry to insert.
  *
  * Behavior:
- *   1. Pushes `order` to the back of `orders`.
- *   2. Sorts the entire `orders` vector by ascending timestamp.
- *   (This is O(n log n) each time, but suffices for moderate data sizes.)
+ *   1. Finds (or creates) the partition that holds user-entered orders (empty `source`).
+ *      File partitions are never modified, so they can be evicted/reloaded independently.
+ *   2. Adds `order` after any entries with the same timestamp (appendUserOrders), which
+ *      keeps that partition sorted without re-sorting it. Copies of the book taken
+ *      earlier still see the old orders.
+ *   3. Re-orders the partitions, since the user partition's first timestamp may change.
  */
-void OrderBook::insertOrder(OrderBookEntry& order)
+void OrderBook::insertOrder(const OrderBookEntry& order)
 {
-    orders.push_back(order);
+    MERKEL_TIMED_SCOPE("OrderBook::insertOrder");
+    appendUserOrders(std::span<const OrderBookEntry>(&order, 1));
+    sortPartitions();
+}
 
-    // Re‐sort by timestamp using compareByTimestamp helper
-    std::sort(orders.begin(), orders.end(),
-        OrderBookEntry::compareByTimestamp);
+/**
+ * insertOrders
+ * Inserts a batch of orders (e.g. one timestep's drained order queue) in one go.
+ *
+ * @param batch  The orders, in any time order.
+ *
+ * Behavior:
+ *   1. Stable-sorts a copy of the batch by timestamp.
+ *   2. Adds it to the user partition (appendUserOrders), existing orders staying ahead
+ *      of new ones with the same timestamp, like insertOrder.
+ *   3. Re-orders the partitions.
+ */
+void OrderBook::insertOrders(std::span<const OrderBookEntry> batch)
+{
+    MERKEL_TIMED_SCOPE("OrderBook::insertOrders");
+    if (batch.empty()) {
+        return;
+    }
+    std::vector<OrderBookEntry> added(batch.begin(), batch.end());
+    std::stable_sort(added.begin(), added.end(), OrderBookEntry::compareByTimestamp);
+    appendUserOrders(added);
+    sortPartitions();
+}
+
+/**
+ * appendUserOrders
+ * Adds time-sorted orders to the user partition without disturbing what copies of
+ * the book (snapshots) see.
+ *
+ * @param added  Non-empty, sorted by timestamp.
+ *
+ * Behavior:
+ *   1. Fast path: if none of `added` is older than the partition's last order, and the
+ *      store has room and this book has seen every entry in it (claiming them with a
+ *      compare-exchange on `claimed`, so two copies can't both append), the orders are
+ *      appended in place. Copies keep their own count, so they never see them.
+ *   2. Otherwise builds a new store with twice the room needed, merging the old
+ *      entries with `added` (std::merge keeps the old ones first among equal
+ *      timestamps). Doubling keeps a run of inserts amortised O(1) each.
+ *   3. Updates the partition's count, range and product list.
+ */
+void OrderBook::appendUserOrders(std::span<const OrderBookEntry> added)
+{
+    Partition& user = userPartition();
+    const size_t count = user.count;
+
+    bool inOrder = (count == 0) ||
+                   !OrderBookEntry::compareByTimestamp(added.front(), user.orders->entries[count - 1]);
+    size_t seen = count;
+    bool appended = inOrder && user.orders &&
+                    user.orders->entries.capacity() - count >= added.size() &&
+                    user.orders->claimed.compare_exchange_strong(seen, count + added.size());
+    if (appended) {
+        user.orders->entries.insert(user.orders->entries.end(), added.begin(), added.end());
+    } else {
+        auto store = std::make_shared<OrderStore>();
+        store->entries.reserve(std::max<size_t>(64, 2 * (count + added.size())));
+        const OrderBookEntry* old = user.orders ? user.orders->entries.data() : nullptr;
+        std::merge(old, old + count, added.begin(), added.end(),
+                   std::back_inserter(store->entries), OrderBookEntry::compareByTimestamp);
+        store->claimed = store->entries.size();
+        user.orders = std::move(store);
+    }
+    user.count = count + added.size();
+
+    // Keep the partition's range and product list in step with its contents
+    const auto& entries = user.orders->entries;
+    user.first = entries.front().timestamp;
+    user.last  = entries[user.count - 1].timestamp;
+    for (const auto& order : added) {
+        if (std::find(user.products.begin(), user.products.end(), order.product) == user.products.end()) {
+            user.products.emplace_back(order.product);
+        }
+    }
+    user.productsKnown = true;
+}
+
+/**
+ * userPartition
+ * Returns the in-memory partition holding user-entered orders, creating it if needed.
+ */
+OrderBook::Partition& OrderBook::userPartition()
+{
+    auto user = std::find_if(partitions.begin(), partitions.end(),
+                             [](const Partition& p) { return p.source.empty(); });
+    if (user == partitions.end()) {
+        partitions.emplace_back();
+        user = partitions.end() - 1;
+        user->loaded = true;   // lives only in memory; never evicted
+    }
+    return *user;
 }
 
 /**
@@ -360,94 +1158,215 @@ void OrderBook::insertOrder(OrderBookEntry& order)
  *         and `price` is taken from the ask price when matched.
  *
  * Behavior:
- *   1. Fetch all asks and bids for this product/timestamp.
+ *   - Runs the arena overload below with a short-lived OrderArena and copies the sales out.
+ *     Callers that match every timestep should keep an OrderArena and use that overload.
+ */
+std::vector<OrderBookEntry> OrderBook::matchAsksToBids(
+    const std::string& product,
+    const std::string& timestamp)
+{
+    OrderArena arena{16 * 1024};
+    auto sales = matchAsksToBids(product, timestamp, arena);
+    return std::vector<OrderBookEntry>(sales.begin(), sales.end());
+}
+
+/**
+ * matchAsksToBids (arena overload)
+ * Same matching as above, but every temporary and result vector lives in `arena`,
+ * so once the arena has warmed up a timestep makes no global allocations.
+ *
+ * @param product    The product to match (e.g., "ETH/USDT")
+ * @param timestamp  The exact time at which to match (e.g., "2020/06/01 12:00:00")
+ * @param arena      Scratch memory; reset it once per timestep. Its sales() vector
+ *                   collects the sales of every product matched since the last reset.
+ *
+ * @return A view of the sales this call appended to arena.sales()
+ *         (valid until the next match on this arena or its reset).
+ *
+ * Behavior:
+ *   1. Fetch all asks and bids for this product/timestamp into arena.asks()/arena.bids().
  *   2. If either side is empty, print a debug message and return empty.
  *   3. Sort asks by ascending price (lowest ask first).
  *   4. Sort bids by descending price (highest bid first).
  *   5. For each ask in the asks list:
  *        a. For each bid in the bids list:
  *             - If bid.price >= ask.price, they can trade at ask.price.
- *             - Create a new OrderBookEntry `sale` with:
+ *             - Record the trade as OrderBookEntry sales with:
  *                   price = ask.price
  *                   amount = determined below
- *                   product = product
- *                   timestamp = timestamp
- *                   orderType = asksale or bidsale depending on who was “simuser”
+ *                   product, timestamp = the ask's (already pooled) strings
+ *                   orderType/username = bidsale for the bid's owner if it is a user's
+ *                   order, asksale for the ask's owner if it is one (both entries when
+ *                   two users' orders cross, so each side's wallet is settled), or a
+ *                   single asksale when neither side belongs to a user
  *             - Determine matched quantity:
  *                   • If bid.amount == ask.amount: both sides fully match.
  *                   • If bid.amount > ask.amount: ask fully matched, adjust bid.
  *                   • If bid.amount < ask.amount: bid fully matched, adjust ask.
- *             - Push the new `sale` entry to `sales` vector.
+ *             - Append the sale entries to arena.sales().
  *             - Break or continue as appropriate once one side’s quantity is exhausted.
- *   6. Return the list of all `sales` created.
+ *   6. Return the span of sales created by this call.
+ *   Steps 2-6 are matchCollected, shared with the many-product overload.
  */
-std::vector<OrderBookEntry> OrderBook::matchAsksToBids(
-    std::string product,
-    std::string timestamp)
+std::span<const OrderBookEntry> OrderBook::matchAsksToBids(
+    const std::string& product,
+    const std::string& timestamp,
+    OrderArena& arena)
 {
+    MERKEL_TIMED_SCOPE("OrderBook::matchAsksToBids");
     // 1) Fetch asks and bids for the given product/timestamp
-    std::vector<OrderBookEntry> asks = getOrders(
-        OrderBookType::ask, product, timestamp);
-    std::vector<OrderBookEntry> bids = getOrders(
-        OrderBookType::bid, product, timestamp);
+    auto& asks = arena.asks();
+    auto& bids = arena.bids();
+    asks.clear();
+    bids.clear();
+    collectOrders(OrderBookType::ask, product, timestamp, asks);
+    collectOrders(OrderBookType::bid, product, timestamp, bids);
 
-    // 2) Initialize an empty vector to hold any sales
-    std::vector<OrderBookEntry> sales;
+    return matchCollected(arena);
+}
+
+/**
+ * matchAsksToBids (many products)
+ * Matches every product in `products` at one timestamp, spreading the products over
+ * the TaskScheduler when the timestep is big enough to be worth it.
+ *
+ * @param products       The products to match, in the order their sales are wanted.
+ * @param timestamp      The exact time at which to match.
+ * @param arena          Receives all sales, appended to arena.sales() in product order.
+ * @param productArenas  Scratch arenas, one per product (grown here as needed); keep
+ *                       them between timesteps like `arena`.
+ *
+ * @return A view of the sales this call appended to arena.sales().
+ *
+ * Behavior:
+ *   1. Collects every product's asks and bids into its own arena on the calling thread
+ *      (collecting may parse or evict partitions, which must not happen concurrently).
+ *   2. Matches the products (matchCollected): as scheduler tasks if there are at least
+ *      two products and PARALLEL_MIN_ORDERS orders in all, otherwise one after another.
+ *      Each product touches only its own arena, so the tasks share nothing.
+ *   3. Appends each product's sales to arena.sales(), in `products` order, so the result
+ *      is the same as matching the products one by one.
+ */
+std::span<const OrderBookEntry> OrderBook::matchAsksToBids(
+    const std::vector<std::string>& products,
+    const std::string& timestamp,
+    OrderArena& arena,
+    std::vector<std::unique_ptr<OrderArena>>& productArenas)
+{
+    MERKEL_TIMED_SCOPE("OrderBook::matchAsksToBids(all)");
+    const size_t PARALLEL_MIN_ORDERS = 2048;   // below this, tasks cost more than they save
 
-    // 3) If no asks or no bids, print debug and return empty sales
+    // 1) Collect each product's orders
+    while (productArenas.size() < products.size()) {
+        productArenas.push_back(std::make_unique<OrderArena>(16 * 1024));
+    }
+    size_t orders = 0;
+    for (size_t i = 0; i < products.size(); ++i) {
+        OrderArena& own = *productArenas[i];
+        own.reset();
+        collectOrders(OrderBookType::ask, products[i], timestamp, own.asks());
+        collectOrders(OrderBookType::bid, products[i], timestamp, own.bids());
+        orders += own.asks().size() + own.bids().size();
+    }
+
+    // 2) Match them
+    if (products.size() >= 2 && orders >= PARALLEL_MIN_ORDERS) {
+        TaskGroup group;
+        for (size_t i = 0; i < products.size(); ++i) {
+            group.run([&own = *productArenas[i]] { matchCollected(own); });
+        }
+        group.wait();
+    } else {
+        for (size_t i = 0; i < products.size(); ++i) {
+            matchCollected(*productArenas[i]);
+        }
+    }
+
+    // 3) Gather the sales in product order
+    auto& sales = arena.sales();
+    const size_t firstSale = sales.size();
+    for (size_t i = 0; i < products.size(); ++i) {
+        const auto& own = productArenas[i]->sales();
+        sales.insert(sales.end(), own.begin(), own.end());
+    }
+    return std::span<const OrderBookEntry>(sales.data() + firstSale, sales.size() - firstSale);
+}
+
+/**
+ * matchCollected
+ * The matching loop shared by the overloads above: sorts arena.asks() and arena.bids()
+ * (already filled with one product's orders at one timestamp) and appends the resulting
+ * sales to arena.sales(). Touches nothing but `arena`.
+ *
+ * @return A view of the sales this call appended.
+ */
+std::span<const OrderBookEntry> OrderBook::matchCollected(OrderArena& arena)
+{
+    auto& asks = arena.asks();
+    auto& bids = arena.bids();
+    // 2) New sales are appended after any already in the arena
+    auto& sales = arena.sales();
+    const size_t firstSale = sales.size();
+
+    // 3) If no asks or no bids, log (debug builds) and return empty sales
     if (asks.empty() || bids.empty()) {
-        std::cout << "OrderBook::matchAsksToBids no bids or asks\n";
-        return sales;
+        LOG_DEBUG("OrderBook::matchAsksToBids no bids or asks");
+        return {};
     }
 
     // 4) Sort asks lowest‐price first, bids highest‐price first
     std::sort(asks.begin(), asks.end(), OrderBookEntry::compareByPriceAsc);
     std::sort(bids.begin(), bids.end(), OrderBookEntry::compareByPriceDesc);
 
-    // DEBUG: Print summary of best/worst prices
-    std::cout << "max ask " << asks.back().price << "\n";
-    std::cout << "min ask " << asks.front().price << "\n";
-    std::cout << "max bid " << bids.front().price << "\n";
-    std::cout << "min bid " << bids.back().price << "\n";
+    // DEBUG: Log summary of best/worst prices (compiled out unless MERKEL_DEBUG_LOG)
+    LOG_DEBUG("max ask " << asks.back().price);
+    LOG_DEBUG("min ask " << asks.front().price);
+    LOG_DEBUG("max bid " << bids.front().price);
+    LOG_DEBUG("min bid " << bids.back().price);
+
+    // Records one trade: a sale per user side (an asksale for the ask's owner, a bidsale
+    // for the bid's owner, both when two users cross), or one plain asksale otherwise
+    auto recordSale = [&sales](const OrderBookEntry& ask, const OrderBookEntry& bid, double amount) {
+        OrderBookEntry sale{
+            ask.price,        // matched price
+            amount,           // matched quantity
+            ask.timestamp,    // timestamp of trade
+            ask.product,      // product being traded
+            OrderBookType::asksale
+        };
+        bool bidUser = bid.isUserOrder();
+        bool askUser = ask.isUserOrder();
+        if (bidUser) {
+            sale.username  = bid.username;
+            sale.orderType = OrderBookType::bidsale;
+            sales.push_back(sale);
+        }
+        if (askUser) {
+            sale.username  = ask.username;
+            sale.orderType = OrderBookType::asksale;
+            sales.push_back(sale);
+        }
+        if (!bidUser && !askUser) {
+            sales.push_back(sale);
+        }
+    };
 
     // 5) Attempt to match each ask with available bids
     for (auto& ask : asks) {
         for (auto& bid : bids) {
             // If bid price >= ask price, a match can occur at ask.price
             if (bid.price >= ask.price) {
-                // Create a sale entry with price = ask.price
-                OrderBookEntry sale{
-                    ask.price,        // matched price
-                    0.0,              // placeholder for matched amount
-                    timestamp,        // timestamp of trade
-                    product,          // product being traded
-                    OrderBookType::asksale // default; may change below
-                };
-
-                // If the bid side belonged to "simuser", mark as bidsale
-                if (bid.username == "simuser") {
-                    sale.username  = "simuser";
-                    sale.orderType = OrderBookType::bidsale;
-                }
-                // If the ask side belonged to "simuser", mark as asksale
-                if (ask.username == "simuser") {
-                    sale.username  = "simuser";
-                    sale.orderType = OrderBookType::asksale;
-                }
-
                 // Determine how much can be matched
                 if (bid.amount == ask.amount) {
                     // 5a) Exact match in quantity: both sides fully matched
-                    sale.amount = ask.amount;   // matched quantity
-                    sales.push_back(sale);      // record the sale
+                    recordSale(ask, bid, ask.amount);   // record the sale
                     bid.amount = 0.0;           // bid is fully consumed
                     // Move on to next ask
                     break;
                 }
                 else if (bid.amount > ask.amount) {
                     // 5b) Bid has larger quantity than ask: ask fully filled
-                    sale.amount = ask.amount;   // matched quantity (ask side)
-                    sales.push_back(sale);
+                    recordSale(ask, bid, ask.amount);   // matched quantity (ask side)
                     bid.amount -= ask.amount;   // reduce bid by the matched amount
                     // Ask is fully consumed; move to next ask
                     break;
@@ -455,8 +1374,7 @@ std::vector<OrderBookEntry> OrderBook::matchAsksToBids(
                 else {
                     // 5c) Bid has smaller quantity than ask: bid fully filled, ask partially remains
                     if (bid.amount > 0.0) {
-                        sale.amount = bid.amount;   // matched quantity (bid side)
-                        sales.push_back(sale);
+                        recordSale(ask, bid, bid.amount);   // matched quantity (bid side)
                         ask.amount -= bid.amount;   // reduce ask by matched amount
                         bid.amount = 0.0;           // bid fully consumed
                         // Continue matching remaining ask amount against next bid
@@ -467,25 +1385,186 @@ std::vector<OrderBookEntry> OrderBook::matchAsksToBids(
         }
     }
 
-    return sales;
+    return std::span<const OrderBookEntry>(sales.data() + firstSale, sales.size() - firstSale);
 }
 
 /**
  * getTradesPerProduct
  * Counts how many orders exist for each distinct product across all `orders`.
  *
+ * @param from  First timestamp to include ("" = from the start).
+ * @param to    First timestamp to leave out ("" = to the end).
  * @return A map<string,int> mapping each product (e.g., "BTC/USDT") to its total order count.
  *
  * Behavior:
- *   - Iterate through every OrderBookEntry in `orders`.
- *   - Increment counts[e.product] by one for each entry.
- *   - Return the map of product → count.
+ *   - Returns the per-product part of countTrades(from, to).
+ */
+std::map<std::string, int> OrderBook::getTradesPerProduct(const std::string& from, const std::string& to)
+{
+    MERKEL_TIMED_SCOPE("OrderBook::getTradesPerProduct");
+    return countTrades(from, to).byProduct;
+}
+
+namespace {
+/**
+ * One counting task's running totals. Products are counted in a dense array indexed by
+ * product ID; users, of which there are few, by their pooled name pointer.
+ */
+struct TradeTally
+{
+    std::vector<long long> products;
+    std::array<long long, 5> sides{};   // indexed by OrderBookType
+    std::unordered_map<const char*, long long> users;
+    std::unordered_map<const char*, std::string_view> userNames;
+    std::unordered_map<std::string_view, long long> unlisted;   // products without an ID
+};
+
+constexpr size_t NO_PRODUCT_ID = static_cast<size_t>(-1);
+}
+
+/**
+ * countTrades
+ * Counts every order per product, per side and per user.
+ *
+ * @param from  First timestamp to include ("" = from the start).
+ * @param to    First timestamp to leave out ("" = to the end).
+ * @return TradeCounts with all three breakdowns and the total.
+ *
+ * Behavior:
+ *   1. Visits the partitions that overlap [from, to) one at a time, counting only their
+ *      slice in the range (sliceOf: binary search). acquire runs on this thread only, so
+ *      lazy loading and eviction work as usual.
+ *   2. Gives every product of the partition a dense ID. Entries' product views are
+ *      pooled (StringPool), so an ID is looked up by pointer, not by string compare.
+ *      A pointer that is not found falls back to a compare by name, and a product not
+ *      in the partition's list at all is counted by name in the task's own tally, so a
+ *      stale product list costs speed, never an exception.
+ *   3. Splits the partition's slice into one piece per scheduler worker; each piece is
+ *      counted by its own task into its own TradeTally (no sharing, no locks). Large
+ *      slices only: below PARALLEL_MIN_ORDERS the calling thread counts alone.
+ *   4. Adds the tallies up and converts IDs and pointers back to strings.
  */
-std::map<std::string, int> OrderBook::getTradesPerProduct()
+TradeCounts OrderBook::countTrades(const std::string& from, const std::string& to)
 {
-    std::map<std::string, int> counts;
-    for (auto& entry : orders) {
-        counts[entry.product]++;
+    MERKEL_TIMED_SCOPE("OrderBook::countTrades");
+    const size_t PARALLEL_MIN_ORDERS = 1 << 15;   // below this, tasks cost more than they save
+
+    std::vector<std::string_view> productNames;          // product ID → pooled name
+    std::unordered_map<const char*, size_t> productIds;  // pooled name pointer → ID
+    std::vector<TradeTally> tallies(TaskScheduler::shared().workerCount());
+
+    // ID of a product, or NO_PRODUCT_ID; read-only while slices are being counted
+    auto productId = [&productIds, &productNames](std::string_view product) {
+        auto found = productIds.find(product.data());
+        if (found != productIds.end()) {
+            return found->second;
+        }
+        auto named = std::find(productNames.begin(), productNames.end(), product);
+        return (named != productNames.end()) ? static_cast<size_t>(named - productNames.begin())
+                                             : NO_PRODUCT_ID;
+    };
+
+    // Counts the slice [first, last) of one partition into `tally`
+    auto countSlice = [&productId](const OrderBookEntry* first, const OrderBookEntry* last,
+                                   TradeTally& tally)
+    {
+        const char* lastProduct = nullptr;     // consecutive rows mostly share a product
+        size_t lastId = 0;
+        const char* lastUser = nullptr;
+        long long* userCount = nullptr;
+        for (auto it = first; it != last; ++it) {
+            if (it->product.data() != lastProduct) {
+                lastProduct = it->product.data();
+                lastId = productId(it->product);
+            }
+            if (lastId != NO_PRODUCT_ID) {
+                ++tally.products[lastId];
+            } else {
+                ++tally.unlisted[it->product];
+            }
+            ++tally.sides[static_cast<size_t>(it->orderType)];
+            if (it->username.data() != lastUser) {
+                lastUser = it->username.data();
+                userCount = &tally.users[lastUser];
+                tally.userNames.emplace(lastUser, it->username);
+            }
+            ++*userCount;
+        }
+    };
+
+    for (auto& p : partitions) {
+        if (!overlaps(p, from, to)) {
+            continue;
+        }
+        std::span<const OrderBookEntry> entries = sliceOf(p, from, to);
+        if (entries.empty()) {
+            continue;
+        }
+
+        // 2) Dense IDs for this partition's products (new ones appended)
+        for (const auto& product : p.products) {
+            std::string_view pooled = StringPool::shared().intern(product);
+            if (productIds.emplace(pooled.data(), productNames.size()).second) {
+                productNames.push_back(pooled);
+            }
+        }
+        for (auto& tally : tallies) {
+            tally.products.resize(productNames.size(), 0);
+        }
+
+        // 3) Count the slices
+        const OrderBookEntry* base = entries.data();
+        size_t slices = std::min(tallies.size(), std::max<size_t>(1, entries.size() / PARALLEL_MIN_ORDERS));
+        if (slices == 1) {
+            countSlice(base, base + entries.size(), tallies[0]);
+            continue;
+        }
+        TaskGroup group;
+        for (size_t t = 0; t < slices; ++t) {
+            const OrderBookEntry* first = base + entries.size() * t / slices;
+            const OrderBookEntry* last  = base + entries.size() * (t + 1) / slices;
+            group.run([&countSlice, first, last, &tally = tallies[t]] {
+                countSlice(first, last, tally);
+            });
+        }
+        group.wait();
+    }
+
+    // 4) Reduce
+    TradeCounts counts;
+    std::vector<long long> products(productNames.size(), 0);
+    std::array<long long, 5> sides{};
+    std::unordered_map<const char*, long long> users;
+    std::unordered_map<const char*, std::string_view> userNames;
+    for (const auto& tally : tallies) {
+        for (const auto& [name, n] : tally.unlisted) {
+            counts.byProduct[std::string(name)] += static_cast<int>(n);
+            counts.total += n;
+        }
+        for (size_t id = 0; id < tally.products.size(); ++id) {
+            products[id] += tally.products[id];
+        }
+        for (size_t side = 0; side < sides.size(); ++side) {
+            sides[side] += tally.sides[side];
+        }
+        for (const auto& [name, n] : tally.users) {
+            users[name] += n;
+        }
+        userNames.insert(tally.userNames.begin(), tally.userNames.end());
+    }
+    for (size_t id = 0; id < products.size(); ++id) {
+        if (products[id] > 0) {
+            counts.byProduct.emplace(productNames[id], static_cast<int>(products[id]));
+        }
+        counts.total += products[id];
+    }
+    for (size_t side = 0; side < sides.size(); ++side) {
+        if (sides[side] > 0) {
+            counts.bySide.emplace(static_cast<OrderBookType>(side), static_cast<int>(sides[side]));
+        }
+    }
+    for (const auto& [name, n] : users) {
+        counts.byUser[std::string(userNames.at(name))] += static_cast<int>(n);
     }
     return counts;
 }
@@ -496,19 +1575,23 @@ std::map<std::string, int> OrderBook::getTradesPerProduct()
  *
  * @param type      OrderBookType (ask or bid)
  * @param product   The product (e.g., "ETH/USDT")
+ * @param from      First timestamp to include ("" = from the start).
+ * @param to        First timestamp to leave out ("" = to the end).
  * @return A vector of (minute, averagePrice) pairs, where:
  *           - minute: string "HH:MM" extracted from entry.timestamp
  *           - averagePrice: average of all entry.price values in that minute, rounded to 6 decimals.
  *
  * Behavior:
- *   1. Build a map from "HH:MM" → vector<double> of prices:
- *        - For each OrderBookEntry in `orders`:
+ *   1. Build a map from "HH:MM" → (∑price, count):
+ *        - For each OrderBookEntry in [from, to) of every partition overlapping the range
+ *          (sliceOf: binary search, so only the window is read):
  *            • If entry.orderType == type and entry.product == product
- *            • Extract `minute = entry.timestamp.substr(11, 5)` (characters 11–15, "HH:MM")
- *            • Append entry.price to pricesByMinute[minute].
+ *            • Extract `minute = entry.timestamp.substr(11, 5)` (characters 11–15, "HH:MM");
+ *              the timestamp is pooled, so the minute is a view, not a new string
+ *            • Add entry.price to that minute's sum and count it.
  *
- *   2. For each (minute, priceList) in pricesByMinute:
- *        - Compute `avg = ∑priceList / priceList.size()`
+ *   2. For each (minute, sum, count):
+ *        - Compute `avg = sum / count`
  *        - Round `avg` to 6 decimal places: `avg = round(avg * 1e6) / 1e6`
  *        - Push `(minute, avg)` into the result vector.
  *
@@ -516,29 +1599,31 @@ std::map<std::string, int> OrderBook::getTradesPerProduct()
  */
 std::vector<std::pair<std::string, double>> OrderBook::getMeanPriceData(
     OrderBookType type,
-    const std::string& product)
+    const std::string& product,
+    const std::string& from,
+    const std::string& to)
 {
-    // 1) Group prices by "HH:MM"
-    std::map<std::string, std::vector<double>> pricesByMinute;
-    for (const auto& entry : orders) {
-        if (entry.orderType == type && entry.product == product) {
-            // Extract substring "HH:MM" from "YYYY/MM/DD HH:MM:SS.ffffff"
-            std::string minute = entry.timestamp.substr(11, 5);
-            pricesByMinute[minute].push_back(entry.price);
+    MERKEL_TIMED_SCOPE("OrderBook::getMeanPriceData");
+    // 1) Sum prices by "HH:MM"
+    std::map<std::string_view, std::pair<double, size_t>> pricesByMinute;
+    for (auto& p : partitions) {
+        if (!overlaps(p, from, to)) {
+            continue;
+        }
+        for (const auto& entry : sliceOf(p, from, to)) {
+            if (entry.orderType == type && entry.product == product) {
+                // Extract substring "HH:MM" from "YYYY/MM/DD HH:MM:SS.ffffff"
+                auto& [sum, count] = pricesByMinute[entry.timestamp.substr(11, 5)];
+                sum += entry.price;
+                ++count;
+            }
         }
     }
 
     // 2) Compute average price per minute
     std::vector<std::pair<std::string, double>> result;
-    for (auto& [minute, priceList] : pricesByMinute) {
-        if (priceList.empty()) {
-            continue;  // Should not happen, but guard anyway
-        }
-        double sum = 0.0;
-        for (double p : priceList) {
-            sum += p;
-        }
-        double avg = sum / priceList.size();
+    for (auto& [minute, total] : pricesByMinute) {
+        double avg = total.first / total.second;
         // Round to 6 decimal places for display clarity
         avg = std::round(avg * 1e6) / 1e6;
         result.emplace_back(minute, avg);
@@ -5,10 +5,34 @@
 #include "Candlestick.h"
 #include "OrderBookEntry.h"
 #include "CSVReader.h"
+#include "OrderArena.h"
+#include <atomic>
+#include <memory>
+#include <span>
+#include <string_view>
+
+/**
+ * How an OrderBook brings its file partitions into memory:
+ *   - eager: every file is parsed up front (in parallel).
+ *   - lazy:  only each file's time range is indexed up front; a file is parsed the first
+ *            time a query touches its range, and cold files are evicted under a memory budget.
+ */
+enum class LoadMode { eager, lazy };
+
+/**
+ * Order counts gathered in one pass over the book (OrderBook::countTrades).
+ */
+struct TradeCounts
+{
+    std::map<std::string, int> byProduct;     // product  → orders
+    std::map<OrderBookType, int> bySide;      // ask/bid  → orders
+    std::map<std::string, int> byUser;        // username → orders ("dataset" for file rows)
+    long long total = 0;
+};
 
 /**
  * Core “OrderBook” class that:
- *  1) Loads two CSV files of raw orders into a single `orders` vector
+ *  1) Loads any number of CSV files of raw orders, one time-sorted partition per file
  *  2) Provides methods to filter and query orders by product, timestamp, and side
  *  3) Computes OHLC candlestick data
  *  4) Computes volume data
@@ -21,11 +45,65 @@ class OrderBook
     public:
     /**
     * Construct by reading two CSV files (e.g. “20200317.csv” and “20200601.csv”).
-    * Each CSV row becomes an OrderBookEntry. After loading, we sort ascending by timestamp.
+    * Same as the file-list constructor (eager) with both files: each file becomes its
+    * own partition, and only a file that fails the std::is_sorted check is sorted.
     */
 
     //OrderBook(const std::string& filename);
     OrderBook(const std::string& file1,const std::string& file2);
+    /**
+    * Construct from any number of CSV files, one partition per file. A file that is
+    * out of time order is sorted on its own (in parallel chunks) when it is parsed.
+    * In lazy mode, `memoryBudget` caps the bytes of parsed partitions kept resident
+    * (0 = no limit); least-recently-used partitions are evicted to stay under it.
+    */
+    explicit OrderBook(const std::vector<std::string>& files,
+                       LoadMode mode = LoadMode::eager,
+                       size_t memoryBudget = 0);
+    /**
+    * Construct an empty book. Days can then be added with addFile().
+    */
+    OrderBook();
+    /**
+    * Copies share every partition's orders (entries a book already sees never change),
+    * so a copy costs O(partitions), not O(orders). Changing either book afterwards (insertOrder,
+    * addFile, ...) does not affect the other. See OrderBookVersions.
+    */
+    OrderBook(const OrderBook&) = default;
+    OrderBook& operator=(const OrderBook&) = default;
+    OrderBook(OrderBook&&) = default;
+    OrderBook& operator=(OrderBook&&) = default;
+    /**
+    * Construct from every file matching a glob such as "data/2020*.csv"
+    * (wildcards are allowed in the file-name part only).
+    */
+    static OrderBook fromGlob(const std::string& pattern,
+                              LoadMode mode = LoadMode::eager,
+                              size_t memoryBudget = 0);
+    /**
+    * Load one more CSV file as its own partition, leaving the others untouched
+    * (in lazy mode it is only indexed until a query needs it).
+    * Returns false if that file is already loaded.
+    */
+    bool addFile(const std::string& file);
+    /**
+    * Add orders that did not come from a file (e.g. generated ones) as one in-memory
+    * partition labelled `source`; it is never evicted by the memory budget.
+    * Returns false if a partition with that label is already loaded.
+    */
+    bool addOrders(const std::string& source, std::vector<OrderBookEntry> orders);
+    /**
+    * Drop the partition loaded from `file`. Returns false if it was not loaded.
+    */
+    bool evictFile(const std::string& file);
+    /**
+    * Return the source file of every loaded partition, in time order.
+    */
+    std::vector<std::string> getLoadedFiles();
+    /**
+    * Approximate bytes held by parsed file partitions right now.
+    */
+    size_t getResidentBytes() const;
     /** return vector of all know products in the dataset*/
     /**
      * Return a vector of all unique products seen across all orders (in no particular order).
@@ -39,8 +117,8 @@ class OrderBook
     */
     /** return vector of Orders according to the sent filters*/
         std::vector<OrderBookEntry> getOrders(OrderBookType type, 
-                                              std::string product, 
-                                              std::string timestamp);
+                                              const std::string& product, 
+                                              const std::string& timestamp);
     /**
         * Return earliest timestamp in the orderbook (smallest lexicographically).
         */
@@ -50,24 +128,41 @@ class OrderBook
  * Given a timestamp `t`, return the next‐higher timestamp in ascending order.
  * If `t` is highest, wrap back to the earliest.
  */
-        std::string getNextTime(std::string timestamp);
+        std::string getNextTime(const std::string& timestamp);
     /**
-     * Insert a new order (e.g. user bid/ask), keeping `orders` sorted by timestamp.
+     * Return every unique timestamp in the book, sorted ascending.
      */
+        std::vector<std::string> getAllTimestamps();
     /**
-    * TASK 4: Count total orders (“trades”) per product across all timestamps/sides.
+    * TASK 4: Count total orders (“trades”) per product across all timestamps/sides,
+    * or only those with a timestamp in [from, to) (an empty `to` has no upper bound).
     * Returns a map: product → count.
     */
-    std::map<std::string, int> getTradesPerProduct();
+    std::map<std::string, int> getTradesPerProduct(const std::string& from = "", const std::string& to = "");
+    /**
+    * Count every order per product, per side and per user in one parallel pass, over the
+    * whole book or the time range [from, to). getTradesPerProduct() is countTrades().byProduct.
+    */
+    TradeCounts countTrades(const std::string& from = "", const std::string& to = "");
     /**
       * TASK 2: Mean‐price data (per minute):
       *   - Group bids (or asks) by truncated minute (“HH:MM”)
       *   - Compute average price in that minute
       *   - Return vector of (minuteLabel, avgPrice)
+      * Only orders with a timestamp in [from, to) count (an empty `to` has no upper bound).
       */
-    std::vector<std::pair<std::string, double>> getMeanPriceData(OrderBookType type, const std::string& product);
+    std::vector<std::pair<std::string, double>> getMeanPriceData(OrderBookType type, const std::string& product,
+                                                                 const std::string& from = "", const std::string& to = "");
 
-        void insertOrder(OrderBookEntry& order);
+    /**
+     * Insert a new order (e.g. user bid/ask), keeping the book sorted by timestamp.
+     * Amortised O(1) when it is not older than the user's latest order.
+     */
+        void insertOrder(const OrderBookEntry& order);
+    /**
+     * Insert many orders at once (one append, or one merge, for the whole batch).
+     */
+        void insertOrders(std::span<const OrderBookEntry> orders);
     /**
         * Match asks to bids for the given product at the given timestamp.
         *   - Fetch all asks and all bids.
@@ -78,37 +173,142 @@ class OrderBook
         *       Decrease amounts on either side as leftover orders.
         *   - Return vector of “sales” (matched trades).
         */
-        std::vector<OrderBookEntry> matchAsksToBids(std::string product, std::string timestamp);
+        std::vector<OrderBookEntry> matchAsksToBids(const std::string& product, const std::string& timestamp);
+    /**
+        * Same matching, but asks/bids/sales are kept in `arena` (reset it once per timestep),
+        * so steady-state matching makes no global allocations. The returned span views the
+        * sales this call appended to arena.sales().
+        */
+        std::span<const OrderBookEntry> matchAsksToBids(const std::string& product,
+                                                        const std::string& timestamp,
+                                                        OrderArena& arena);
+    /**
+        * Match every product in `products` at `timestamp`, in parallel on the TaskScheduler
+        * when the timestep is large. Each product is matched in its own arena from
+        * `productArenas` (grown as needed; keep it between timesteps); the sales are then
+        * appended to arena.sales() in product order, exactly as one-by-one matching would.
+        */
+        std::span<const OrderBookEntry> matchAsksToBids(const std::vector<std::string>& products,
+                                                        const std::string& timestamp,
+                                                        OrderArena& arena,
+                                                        std::vector<std::unique_ptr<OrderArena>>& productArenas);
     /**
          * Return highest price among a vector of orders.
          */
-        static double getHighPrice(std::vector<OrderBookEntry>& orders);
+        static double getHighPrice(const std::vector<OrderBookEntry>& orders);
     /**
     * Return lowest price among a vector of orders.
     */
-        static double getLowPrice(std::vector<OrderBookEntry>& orders);
+        static double getLowPrice(const std::vector<OrderBookEntry>& orders);
         /** Compute OHLC candlesticks for one product & side over all timestamps */
         std::vector<Candlestick>
     /**
     * TASK 1: Compute OHLC candlesticks:
-    * For every unique timestamp (collected from CSVReader::getAllTimestamps()):
+    * For every unique timestamp in the book (from getAllTimestamps()):
     *   - Filter orders matching (side, product, timestamp)
     *   - Compute high = max(price), low = min(price)
     *   - Compute VWAP‐style close = ∑(price*amount) / ∑(amount)
     *   - Open = previous close (or equal to close for first candle)
     *   - Append a new Candlestick(ts, open, high, low, close)
+    * Only timestamps in [from, to) are visited (an empty `to` has no upper bound).
     */
-        getCandlestickData(OrderBookType side, const std::string& product);
+        getCandlestickData(OrderBookType side, const std::string& product,
+                           const std::string& from = "", const std::string& to = "");
         std::vector<std::pair<std::string,double>>
     /**
     * TASK 3a (part): Volume data:
     * For each timestamp, sum up total `amount` of orders (side, product).
-    * Return vector of (timestamp, totalAmount).
+    * Return vector of (timestamp, totalAmount), for the timestamps in [from, to)
+    * (an empty `to` has no upper bound).
     */
-        getVolumeData(OrderBookType side, const std::string& product);
+        getVolumeData(OrderBookType side, const std::string& product,
+                      const std::string& from = "", const std::string& to = "");
 
     private:
-        std::vector<OrderBookEntry> orders;// All loaded ask/bid entries, sorted by timestamp
+    /**
+    * Append-only storage for a partition's orders, shared by copies of the book.
+    * Entries are only ever added past the end, into capacity reserved up front, so
+    * `entries` never reallocates and the entries a copy already sees never change.
+    * `claimed` counts the entries handed out; only a book that has seen all of them
+    * may append (see appendUserOrders).
+    */
+        struct OrderStore
+        {
+            std::vector<OrderBookEntry> entries;
+            std::atomic<size_t> claimed{0};
+        };
+    /**
+    * One independently loaded slice of the book: the orders from one CSV file
+    * (or, with an empty `source`, the orders entered by the user), sorted by timestamp.
+    * This book sees the first `count` entries of `orders`; copies of the book
+    * (snapshots) share the store and keep their own count, so later appends and
+    * replacements of the store are invisible to them.
+    */
+        struct Partition
+        {
+            std::string source;
+            std::string first, last;            // time range, known even before parsing
+            std::shared_ptr<OrderStore> orders; // null until parsed
+            size_t count = 0;                   // entries of `orders` in this partition
+            std::vector<std::string> products;  // distinct products; kept after eviction
+            bool productsKnown = false;         // set once the file has been parsed
+            bool loaded = false;
+            bool pinned = false;                // in memory only: no file to reload from
+            size_t bytes = 0;                   // approximate memory held by `orders`
+            unsigned long long lastUse = 0;     // LRU clock value of the latest access
+
+            const std::string& firstTime() const { return first; }
+            const std::string& lastTime() const { return last; }
+        };
+
+    /** Read one CSV file into a time-sorted partition. */
+        static Partition loadPartition(const std::string& file);
+    /** Record only a file's time range (first/last valid row) without parsing it. */
+        static Partition indexPartition(const std::string& file);
+    /** Parse `p` into memory (sorting it if needed) and fill in its range and size. */
+        static void parsePartition(Partition& p);
+    /** Sort `orders` if needed, store them in `p` and fill in its range, size and products. */
+        static void finishPartition(Partition& p, std::vector<OrderBookEntry> orders);
+    /** The partition holding user-entered orders (empty `source`), created on first use. */
+        Partition& userPartition();
+    /** Add time-sorted `added` to the user partition, after existing orders with equal timestamps. */
+        void appendUserOrders(std::span<const OrderBookEntry> added);
+    /** Make sure `p` is parsed, mark it most recently used, and return its orders. */
+        std::span<const OrderBookEntry> acquire(Partition& p);
+    /** Evict least-recently-used file partitions (never `keep`) until under budget. */
+        void enforceBudget(const Partition* keep);
+    /** Per-timestamp totals of one side/product, for candles and volume. */
+        struct TimestampTotals;
+    /** Totals for every timestamp in [from, to), in time order (see getVolumeData). */
+        std::vector<TimestampTotals> totalsPerTimestamp(OrderBookType side, std::string_view product,
+                                                        std::string_view from, std::string_view to);
+    /** Acquire `p` and return its orders with a timestamp in [from, to) (empty `to`: no bound). */
+        std::span<const OrderBookEntry> sliceOf(Partition& p, std::string_view from, std::string_view to);
+    /** True if `p` may hold timestamps in [from, to), judged from its range alone. */
+        static bool overlaps(const Partition& p, std::string_view from, std::string_view to);
+    /** Sort the asks and bids already in `arena` and append their matches to its sales(). */
+        static std::span<const OrderBookEntry> matchCollected(OrderArena& arena);
+    /** Append every order matching side/product/timestamp to `out` (any vector type). */
+        template <typename Vector>
+        void collectOrders(OrderBookType type, std::string_view product,
+                           std::string_view timestamp, Vector& out);
+    /** Re-establish time order of `partitions` (by first timestamp) after a change. */
+        void sortPartitions();
+    /**
+    * Merge any number of runs, each already sorted by timestamp, into one sorted vector.
+    * Entries with equal timestamps keep the order of the runs they came from.
+    */
+        static std::vector<OrderBookEntry> mergeSortedRuns(std::vector<std::vector<OrderBookEntry>>& runs);
+    /**
+    * Sort one out-of-order run: sort contiguous chunks on separate threads, then merge them.
+    */
+        static void parallelSortByTimestamp(std::vector<OrderBookEntry>& run);
+
+        std::vector<Partition> partitions;// Non-empty partitions, ordered by first timestamp
+        LoadMode           mode = LoadMode::eager;
+        size_t             memoryBudget = 0;   // 0 = unlimited
+        size_t             residentBytes = 0;  // sum of `bytes` over parsed file partitions
+        unsigned long long useClock = 0;       // ticks once per partition access
 
 
 };
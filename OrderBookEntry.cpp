@@ -1,23 +1,34 @@
 #include "OrderBookEntry.h"
+#include "StringPool.h"
 
 OrderBookEntry::OrderBookEntry( double _price, 
                         double _amount, 
-                        std::string _timestamp, 
-                        std::string _product, 
+                        std::string_view _timestamp, 
+                        std::string_view _product, 
                         OrderBookType _orderType, 
-                        std::string _username)
+                        std::string_view _username)
 : price(_price), 
   amount(_amount), 
-  timestamp(_timestamp),
-  product(_product), 
+  timestamp(StringPool::shared().intern(_timestamp)),
+  product(StringPool::shared().intern(_product)), 
   orderType(_orderType), 
-  username(_username)
+  username(StringPool::shared().intern(_username))
 {
   
     
 }
 
-OrderBookType OrderBookEntry::stringToOrderBookType(std::string s)
+bool OrderBookEntry::isUserOrder() const
+{
+  static const std::string_view dataset = StringPool::shared().intern("dataset");
+  if (username.data() == dataset.data())
+  {
+    return false;
+  }
+  return username != dataset;
+}
+
+OrderBookType OrderBookEntry::stringToOrderBookType(std::string_view s)
 {
   if (s == "ask")
   {
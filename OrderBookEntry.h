@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include "StringPool.h"
 /**
  * Enum for the type of orderbook entry.
  */
@@ -14,40 +16,50 @@ enum class OrderBookType{bid, ask, unknown, asksale, bidsale};
  *   - product: e.g. "ETH/USDT"
  *   - orderType: bid or ask (or sale versions for matched orders)
  *   - username: who placed it (e.g. "dataset" or "simuser")
+ *
+ * The three string fields are PooledStrings from StringPool::shared(): the constructor
+ * interns them, so an entry owns no heap memory and copying one is a plain memberwise
+ * copy. A field can only be assigned another pooled string (another entry's field, or
+ * StringPool::shared().intern(...)), so it can never be left viewing a temporary.
  */
 class OrderBookEntry
 {
     public:
     
-    // Primary constructor
+    // Primary constructor (interns the three strings)
         OrderBookEntry( double _price, 
                         double _amount, 
-                        std::string _timestamp, 
-                        std::string _product, 
+                        std::string_view _timestamp, 
+                        std::string_view _product, 
                         OrderBookType _orderType, 
-                        std::string username = "dataset");
+                        std::string_view username = "dataset");
     /**
          * Convert string "ask" / "bid" / etc. into our enum.
          */
-        static OrderBookType stringToOrderBookType(std::string s);
+        static OrderBookType stringToOrderBookType(std::string_view s);
     // Sorting helpers (not used directly here, but available if needed):
-        static bool compareByTimestamp(OrderBookEntry& e1, OrderBookEntry& e2)
+        static bool compareByTimestamp(const OrderBookEntry& e1, const OrderBookEntry& e2)
         {
             return e1.timestamp < e2.timestamp;
         }  
-        static bool compareByPriceAsc(OrderBookEntry& e1, OrderBookEntry& e2)
+        static bool compareByPriceAsc(const OrderBookEntry& e1, const OrderBookEntry& e2)
         {
             return e1.price < e2.price;
         }
-         static bool compareByPriceDesc(OrderBookEntry& e1, OrderBookEntry& e2)
+         static bool compareByPriceDesc(const OrderBookEntry& e1, const OrderBookEntry& e2)
         {
             return e1.price > e2.price;
         }
+    /**
+         * True if this order was placed by a trader rather than loaded from the dataset.
+         * Checks the pooled "dataset" pointer first, so dataset rows need no string compare.
+         */
+        bool isUserOrder() const;
 
         double price;
         double amount;
-        std::string timestamp;
-        std::string product;
+        PooledString timestamp;
+        PooledString product;
         OrderBookType orderType;
-        std::string username;
+        PooledString username;
 };
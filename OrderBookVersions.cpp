@@ -0,0 +1,45 @@
+#include "OrderBookVersions.h"
+#include "Metrics.h"
+
+/**
+ * OrderBookVersions:
+ *   Each version is an immutable OrderBook copy behind a shared_ptr. publish() swaps in
+ *   a new one; a reader that loaded the old pointer keeps it alive until it is done, and
+ *   the last holder frees it (together with any order vectors only it still shares).
+ *   Nothing ever calls a member on a published book, only its copy constructor, so
+ *   concurrent readers see plain immutable data.
+ */
+
+OrderBookVersions::OrderBookVersions(const OrderBook& _book)
+: book(_book),
+  current(std::make_shared<const Version>(Version{1, _book}))
+{
+}
+
+/**
+ * publish
+ * Copies the book (sharing its order data) and makes the copy the current version.
+ */
+void OrderBookVersions::publish()
+{
+    MERKEL_TIMED_SCOPE("OrderBookVersions::publish");
+    std::uint64_t next = current.load()->number + 1;
+    current.store(std::make_shared<const Version>(Version{next, book}));
+}
+
+/**
+ * snapshot
+ * @return A copy of the current version, which the caller may query freely (queries
+ *         update the copy's own lazy-loading state, never the shared data).
+ */
+OrderBook OrderBookVersions::snapshot() const
+{
+    MERKEL_TIMED_SCOPE("OrderBookVersions::snapshot");
+    std::shared_ptr<const Version> version = current.load();
+    return version->book;
+}
+
+std::uint64_t OrderBookVersions::version() const
+{
+    return current.load()->number;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "OrderBook.h"
+
+/**
+ * OrderBookVersions: snapshot isolation for reading an OrderBook from other threads.
+ *   - the writer thread owns the OrderBook and calls publish() after changing it
+ *     (insertOrder, addFile, ...); that stores a copy as the new current version
+ *   - any thread calls snapshot() for its own copy of the current version and queries
+ *     it while the writer goes on inserting and matching; it never changes under them
+ *   - copies share the orders themselves (OrderBook partitions are append-only), so
+ *     publishing and taking a snapshot cost O(partitions), and readers and the writer
+ *     never wait for each other beyond one atomic pointer load / store
+ * A lazy-mode snapshot parses the partitions it touches on its own; that work is not
+ * shared with the writer or other snapshots.
+ */
+class OrderBookVersions
+{
+    public:
+    /** Publish `book` as version 1. `book` must outlive this object. */
+        explicit OrderBookVersions(const OrderBook& book);
+        OrderBookVersions(const OrderBookVersions&) = delete;
+        OrderBookVersions& operator=(const OrderBookVersions&) = delete;
+
+    /** Writer thread only: publish the book's current state as the next version. */
+        void publish();
+    /** Any thread: a private copy of the current version. */
+        OrderBook snapshot() const;
+    /** Any thread: the current version number (1 until the first publish()). */
+        std::uint64_t version() const;
+
+    private:
+        struct Version
+        {
+            std::uint64_t number;
+            OrderBook book;
+        };
+
+        const OrderBook& book;
+        std::atomic<std::shared_ptr<const Version>> current;
+};
@@ -0,0 +1,191 @@
+#include "OrderFlowGenerator.h"
+#include "OrderBook.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+/**
+ * OrderFlowGenerator:
+ *   Each product's mid price follows a geometric random walk (one step per timestamp).
+ *   Orders are dealt round-robin over the products; each is a bid or ask with equal
+ *   probability, priced up to `spread` away from the mid on its own side, or (with
+ *   probability `crossingRate`) on the other side of the mid, which is what makes
+ *   bids and asks cross and trade when the book is matched.
+ */
+
+namespace
+{
+    const char* const kBases[]  = {"ETH", "DOGE", "LTC", "XRP", "ADA", "SOL", "DOT", "BNB"};
+    const char* const kQuotes[] = {"BTC", "USDT"};
+}
+
+/**
+ * Constructor
+ * Names the products ("BTC/USDT", then each base against BTC and USDT, then "C<n>/USDT"
+ * once those run out) and seeds their starting mids from the generator.
+ */
+OrderFlowGenerator::OrderFlowGenerator(const OrderFlowConfig& _config)
+: config(_config),
+  state(_config.seed)
+{
+    for (size_t i = 0; i < config.products; ++i) {
+        if (i == 0) {
+            products.emplace_back("BTC/USDT");
+        } else if (i <= std::size(kBases) * std::size(kQuotes)) {
+            size_t k = i - 1;
+            products.emplace_back(std::string(kBases[k % std::size(kBases)]) + "/" +
+                                  kQuotes[k / std::size(kBases)]);
+        } else {
+            products.emplace_back("C" + std::to_string(i) + "/USDT");
+        }
+        mids.push_back(std::exp(normal() * 3.0));   // spread prices over many magnitudes
+    }
+    if (config.ordersPerTimestamp == 0 || products.empty()) {
+        config.timestamps = 0;
+    }
+}
+
+const std::vector<std::string>& OrderFlowGenerator::productNames() const
+{
+    return products;
+}
+
+/**
+ * next
+ * @param batch  Cleared and filled with one timestamp's orders (ordersPerTimestamp of them).
+ * @return false (and an empty batch) once `timestamps` steps have been generated.
+ */
+bool OrderFlowGenerator::next(std::vector<OrderBookEntry>& batch)
+{
+    batch.clear();
+    if (step >= config.timestamps) {
+        return false;
+    }
+
+    for (double& mid : mids) {
+        mid *= std::exp(config.volatility * normal());
+    }
+
+    std::string timestamp = formatTimestamp(step++);
+    batch.reserve(config.ordersPerTimestamp);
+    for (size_t i = 0; i < config.ordersPerTimestamp; ++i) {
+        size_t p = i % products.size();
+        bool bid = uniform() < 0.5;
+        bool crossing = uniform() < config.crossingRate;
+        double offset = config.spread * uniform();
+        // Bids normally sit below the mid and asks above it; crossing orders swap sides
+        bool below = (bid != crossing);
+        double price = mids[p] * (below ? 1.0 - offset : 1.0 + offset);
+        double amount = 0.01 + std::exp(normal());
+        batch.emplace_back(price, amount, timestamp, products[p],
+                           bid ? OrderBookType::bid : OrderBookType::ask);
+    }
+    return true;
+}
+
+/**
+ * writeCSV
+ * Writes every remaining timestamp's orders as "timestamp,product,side,price,amount"
+ * rows, the layout CSVReader reads.
+ */
+size_t OrderFlowGenerator::writeCSV(std::ostream& out)
+{
+    std::vector<OrderBookEntry> batch;
+    std::string buffer;
+    char row[160];
+    size_t rows = 0;
+    while (next(batch)) {
+        buffer.clear();
+        for (const auto& e : batch) {
+            int len = std::snprintf(row, sizeof row, "%.*s,%.*s,%s,%.10g,%.10g\n",
+                                    static_cast<int>(e.timestamp.size()), e.timestamp.data(),
+                                    static_cast<int>(e.product.size()), e.product.data(),
+                                    e.orderType == OrderBookType::bid ? "bid" : "ask",
+                                    e.price, e.amount);
+            buffer.append(row, static_cast<size_t>(len));
+        }
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        rows += batch.size();
+    }
+    return rows;
+}
+
+/**
+ * loadInto
+ * Streams the remaining flow into `book` without a CSV round trip, one partition per
+ * `partitionRows` rows (rounded up to whole timestamps, so partitions don't overlap).
+ */
+size_t OrderFlowGenerator::loadInto(OrderBook& book, const std::string& label, size_t partitionRows)
+{
+    std::vector<OrderBookEntry> batch;
+    std::vector<OrderBookEntry> partition;
+    size_t rows = 0, partitions = 0;
+    while (next(batch)) {
+        partition.insert(partition.end(), batch.begin(), batch.end());
+        if (partition.size() >= partitionRows) {
+            rows += partition.size();
+            book.addOrders(label + "#" + std::to_string(partitions++), std::move(partition));
+            partition = {};
+        }
+    }
+    if (!partition.empty()) {
+        rows += partition.size();
+        book.addOrders(label + "#" + std::to_string(partitions), std::move(partition));
+    }
+    return rows;
+}
+
+/**
+ * nextBits
+ * splitmix64: a small, fast generator whose output depends only on the seed.
+ */
+std::uint64_t OrderFlowGenerator::nextBits()
+{
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+double OrderFlowGenerator::uniform()
+{
+    return static_cast<double>(nextBits() >> 11) * 0x1.0p-53;
+}
+
+/**
+ * normal
+ * Box-Muller transform of two uniforms (the second output is not kept).
+ */
+double OrderFlowGenerator::normal()
+{
+    double u1 = uniform();
+    double u2 = uniform();
+    if (u1 <= 0.0) {
+        u1 = 0x1.0p-53;
+    }
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+/**
+ * formatTimestamp
+ * "YYYY/MM/DD HH:MM:SS.ffffff" for startSeconds + step * stepMicros.
+ */
+std::string OrderFlowGenerator::formatTimestamp(size_t n) const
+{
+    using namespace std::chrono;
+    std::int64_t micros = config.startSeconds * 1000000 +
+                          static_cast<std::int64_t>(n) * config.stepMicros;
+    sys_days day = floor<days>(sys_time<microseconds>(microseconds(micros)));
+    year_month_day ymd{day};
+    std::int64_t inDay = micros - duration_cast<microseconds>(day.time_since_epoch()).count();
+
+    char buf[64];   // room for any field values, not just in-range ones
+    std::snprintf(buf, sizeof buf, "%04d/%02u/%02u %02lld:%02lld:%02lld.%06lld",
+                  static_cast<int>(ymd.year()), static_cast<unsigned>(ymd.month()),
+                  static_cast<unsigned>(ymd.day()),
+                  static_cast<long long>(inDay / 3600000000LL),
+                  static_cast<long long>(inDay / 60000000LL % 60),
+                  static_cast<long long>(inDay / 1000000LL % 60),
+                  static_cast<long long>(inDay % 1000000LL));
+    return buf;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "OrderBookEntry.h"
+
+class OrderBook;
+
+/** Shape of the generated order flow. */
+struct OrderFlowConfig
+{
+    std::uint64_t seed = 42;
+    size_t products = 5;               // distinct products, e.g. "ETH/BTC"
+    size_t timestamps = 1000;          // timesteps to generate
+    size_t ordersPerTimestamp = 100;   // orders per timestep, spread over the products
+    double volatility = 0.001;         // std. dev. of each product's relative mid move per step
+    double spread = 0.01;              // orders sit up to this fraction away from the mid
+    double crossingRate = 0.05;        // fraction of orders priced through the mid (they can match)
+    std::int64_t startSeconds = 1577836800;   // first timestamp, seconds since 1970 (2020/01/01)
+    std::int64_t stepMicros = 5000000;        // gap between timestamps
+};
+
+/**
+ * OrderFlowGenerator: a deterministic source of synthetic order book data.
+ *   - next(batch) yields one timestamp's orders at a time, so any size can be streamed
+ *   - writeCSV writes rows in the dataset's format (timestamp,product,side,price,amount)
+ *   - loadInto adds the flow to an OrderBook as in-memory partitions
+ * The random generator and distributions are implemented here rather than taken from
+ * <random>, whose distributions differ between standard libraries. The same binary
+ * given the same seed always produces the same rows; across platforms the rows may
+ * still differ slightly, since prices go through the C library's exp/log/cos.
+ */
+class OrderFlowGenerator
+{
+    public:
+        explicit OrderFlowGenerator(const OrderFlowConfig& config);
+
+    /** Replace `batch` with the next timestamp's orders; false once all are generated. */
+        bool next(std::vector<OrderBookEntry>& batch);
+    /** Write the remaining flow as CSV rows; returns the number of rows written. */
+        size_t writeCSV(std::ostream& out);
+    /**
+    * Add the remaining flow to `book` as partitions of about `partitionRows` rows,
+    * labelled "<label>#0", "<label>#1", ...; returns the number of orders added.
+    */
+        size_t loadInto(OrderBook& book, const std::string& label = "generated",
+                        size_t partitionRows = 1000000);
+    /** Names of the generated products, e.g. "ETH/BTC". */
+        const std::vector<std::string>& productNames() const;
+
+    private:
+        std::uint64_t nextBits();
+        double uniform();   // [0, 1)
+        double normal();    // mean 0, std. dev. 1
+        std::string formatTimestamp(size_t step) const;
+
+        OrderFlowConfig config;
+        std::uint64_t state;
+        size_t step = 0;
+        std::vector<std::string> products;
+        std::vector<double> mids;
+};
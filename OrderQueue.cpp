@@ -0,0 +1,81 @@
+#include "OrderQueue.h"
+#include <algorithm>
+#include <bit>
+
+/**
+ * OrderQueue:
+ *   A bounded ring in the style of Vyukov's array queue. Slot i starts with sequence i.
+ *   A producer that finds sequence == pos may claim position `pos` (CAS on tail), fills
+ *   the slot and publishes it by setting sequence = pos + 1. The consumer reads a slot
+ *   once its sequence is head + 1 and hands it back to producers for the next lap by
+ *   setting sequence = head + capacity.
+ */
+
+OrderQueue::OrderQueue(size_t _capacity)
+: mask(std::bit_ceil(std::max<size_t>(_capacity, 2)) - 1),
+  ring(std::make_unique<Slot[]>(mask + 1))
+{
+    for (size_t i = 0; i <= mask; ++i) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * tryPush
+ * Behavior:
+ *   - sequence == pos: the slot is free for this lap; claim it by advancing tail.
+ *   - sequence <  pos: the consumer has not freed it yet, i.e. the ring is full.
+ *   - sequence >  pos: another producer claimed `pos` first; reload tail and retry.
+ */
+bool OrderQueue::tryPush(const OrderBookEntry& order)
+{
+    size_t pos = tail.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = ring[pos & mask];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+        if (diff == 0) {
+            if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.order = order;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+            // CAS failure reloaded `pos`; try again
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * drain
+ * Takes orders in queue order until the queue is empty (or `max` were taken). A slot
+ * that has been claimed but not yet filled stops the drain; it is picked up next time.
+ */
+size_t OrderQueue::drain(std::vector<OrderBookEntry>& out, size_t max)
+{
+    size_t pos = head.load(std::memory_order_relaxed);
+    size_t taken = 0;
+    while (max == 0 || taken < max) {
+        Slot& slot = ring[pos & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            break;
+        }
+        out.push_back(*slot.order);
+        slot.order.reset();
+        slot.sequence.store(pos + mask + 1, std::memory_order_release);
+        ++pos;
+        ++taken;
+    }
+    head.store(pos, std::memory_order_relaxed);
+    return taken;
+}
+
+size_t OrderQueue::size() const
+{
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_relaxed);
+    return t > h ? t - h : 0;
+}
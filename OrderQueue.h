@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "OrderBookEntry.h"
+
+/**
+ * OrderQueue: bounded multi-producer / single-consumer ring buffer of orders.
+ *   - any number of threads may tryPush() at once, without locks; a push fails
+ *     (returns false) only when the ring is full
+ *   - one consumer thread (the matching loop) drains it in batches with drain()
+ *   - each slot carries a sequence number that says whose turn it is, so producers
+ *     claim slots with one compare-and-swap and the consumer never writes the tail
+ * Capacity is rounded up to a power of two.
+ */
+class OrderQueue
+{
+    public:
+        explicit OrderQueue(size_t capacity = 4096);
+        OrderQueue(const OrderQueue&) = delete;
+        OrderQueue& operator=(const OrderQueue&) = delete;
+
+    /** Any thread: enqueue a copy of `order`; false if the queue is full. */
+        bool tryPush(const OrderBookEntry& order);
+    /** Consumer only: move up to `max` queued orders (0 = all) onto `out`; returns how many. */
+        size_t drain(std::vector<OrderBookEntry>& out, size_t max = 0);
+    /** Approximate number of queued orders (exact when producers are idle). */
+        size_t size() const;
+        size_t capacity() const { return mask + 1; }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            std::optional<OrderBookEntry> order;
+        };
+
+        size_t mask;
+        std::unique_ptr<Slot[]> ring;
+        alignas(64) std::atomic<size_t> tail{0};   // next position producers claim
+        alignas(64) std::atomic<size_t> head{0};   // next position the consumer reads
+};
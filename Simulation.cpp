@@ -0,0 +1,193 @@
+#include "Simulation.h"
+#include "Metrics.h"
+#include "StringPool.h"
+#include <algorithm>
+
+/**
+ * Constructor
+ * @param book      The order book to trade against.
+ * @param wallet    The user's wallet; reservations and fills are applied to it.
+ * @param username  The name stamped on the user's orders (and matched on their sales).
+ * @param queueCapacity  Size of the submitOrder() queue (rounded up to a power of two).
+ *
+ * Starts at the book's earliest timestamp and caches the product list, so steps
+ * don't rebuild it; placeOrder() adds products the book had not seen.
+ */
+Simulation::Simulation(OrderBook& book, Wallet& _wallet, std::string _username,
+                       size_t queueCapacity)
+: orderBook(book),
+  wallet(_wallet),
+  username(std::move(_username)),
+  current(book.getEarliestTime()),
+  products(book.getKnownProducts()),
+  ingress(queueCapacity)
+{
+}
+
+const std::string& Simulation::currentTime() const
+{
+    return current;
+}
+
+const Simulation::Stats& Simulation::stats() const
+{
+    return totals;
+}
+
+/**
+ * placeOrder
+ * Stamps `order` with the current time and the user's name, reserves the funds it
+ * needs, and inserts it into the book.
+ *
+ * @return true if the order was placed; false (nothing changed) if the wallet lacks
+ *         the available funds.
+ */
+bool Simulation::placeOrder(OrderBookEntry order)
+{
+    order.timestamp = StringPool::shared().intern(current);
+    order.username  = StringPool::shared().intern(username);
+    if (!wallet.reserveOrder(order)) {
+        ++totals.ordersRejected;
+        return false;
+    }
+    orderBook.insertOrder(order);
+    if (std::find(products.begin(), products.end(), order.product) == products.end()) {
+        products.emplace_back(order.product);
+    }
+    ++totals.ordersPlaced;
+    return true;
+}
+
+/**
+ * attachAccounts
+ * From the next step on, other traders' orders are checked against `manager` and
+ * their fills settled into it. The manager must outlive the simulation.
+ */
+void Simulation::attachAccounts(WalletManager& manager)
+{
+    accounts = &manager;
+}
+
+bool Simulation::submitOrder(OrderBookEntry order)
+{
+    if (!order.isUserOrder()) {
+        order.username = StringPool::shared().intern(username);
+    }
+    return ingress.tryPush(order);
+}
+
+/**
+ * drainQueue
+ * Behavior:
+ *   - Takes at most one queue's worth of orders, so producers that keep submitting
+ *     cannot hold a step up; the rest wait for the next step.
+ *   - Stamps each with the current time; the user's orders reserve funds first and
+ *     are dropped (counted as rejected) if the wallet can't cover them. With accounts
+ *     attached, another trader's order is dropped the same way if that trader has an
+ *     account whose balances can't cover it.
+ *   - Enters the accepted orders with one OrderBook::insertOrders call.
+ */
+void Simulation::drainQueue(StepResult& result)
+{
+    drained.clear();
+    if (ingress.drain(drained, ingress.capacity()) == 0) {
+        return;
+    }
+
+    const PooledString now  = StringPool::shared().intern(current);
+    const PooledString user = StringPool::shared().intern(username);
+    size_t kept = 0;
+    for (auto& order : drained) {
+        order.timestamp = now;
+        if (order.username == user && !wallet.reserveOrder(order)) {
+            ++result.queuedRejected;
+            continue;
+        }
+        AccountId account;
+        if (accounts && order.username != user && accounts->findAccount(order.username, account) &&
+            !accounts->canFulfillOrder(account, order))
+        {
+            ++result.queuedRejected;
+            continue;
+        }
+        if (std::find(products.begin(), products.end(), order.product) == products.end()) {
+            products.emplace_back(order.product);
+        }
+        drained[kept++] = order;
+    }
+    drained.erase(drained.begin() + static_cast<long>(kept), drained.end());
+    orderBook.insertOrders(drained);
+
+    result.queuedPlaced = kept;
+    totals.ordersPlaced += kept;
+    totals.ordersRejected += result.queuedRejected;
+}
+
+/**
+ * step
+ * Behavior:
+ *   0) Enters the orders queued by submitOrder() (drainQueue).
+ *   1) Resets the match arena and matches every product at the current timestamp
+ *      (products in parallel on the TaskScheduler when the timestep is large);
+ *      all sales end up in the arena, in product order.
+ *   2) Settles the user's sales in one batch (Wallet::settle) and, with accounts
+ *      attached, routes every other trader's sale to its account and applies them
+ *      as one batch (WalletManager::queueSale / applyPending).
+ *   3) Releases what is still reserved for the user's unfilled orders at this
+ *      timestamp; they can no longer match.
+ *   4) Advances to the next timestamp; `wrapped` is set when the book wraps
+ *      around to its earliest timestamp.
+ */
+Simulation::StepResult Simulation::step()
+{
+    MERKEL_TIMED_SCOPE("Simulation::step");
+    StepResult result;
+    result.timestamp = current;
+    drainQueue(result);
+
+    matchArena.reset();
+    orderBook.matchAsksToBids(products, current, matchArena, productArenas);
+    result.sales = matchArena.sales();
+    result.settlement = wallet.settle(result.sales, username);
+    wallet.expireOrders(current);
+    if (accounts) {
+        for (auto const& sale : result.sales) {
+            if (sale.username != username && sale.isUserOrder() && accounts->queueSale(sale)) {
+                ++result.accountFills;
+            }
+        }
+        accounts->applyPending();
+    }
+
+    ++totals.timesteps;
+    totals.sales += result.sales.size();
+    totals.userFills += result.settlement.fills;
+    totals.accountFills += result.accountFills;
+    for (auto const& sale : result.sales) {
+        totals.volume += sale.amount;
+    }
+
+    std::string next = orderBook.getNextTime(current);
+    result.wrapped = (next <= current);
+    current = std::move(next);
+    return result;
+}
+
+/**
+ * runToEnd
+ * Steps until a step reports wrapping (the last timestamp has been matched), or at
+ * once if the book is empty.
+ */
+size_t Simulation::runToEnd()
+{
+    size_t steps = 0;
+    if (current.empty()) {
+        return steps;
+    }
+    for (;;) {
+        ++steps;
+        if (step().wrapped) {
+            return steps;
+        }
+    }
+}
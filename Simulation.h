@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "OrderBook.h"
+#include "OrderArena.h"
+#include "OrderQueue.h"
+#include "Wallet.h"
+#include "WalletManager.h"
+
+/**
+ * Simulation: the exchange loop without any user interface.
+ *   - placeOrder(order) reserves the user's funds and enters the order at the current time
+ *   - submitOrder(order) may be called from any thread: the order waits in a lock-free
+ *     queue and is entered by the next step(), together with everything else queued
+ *   - step() matches every product at the current time, settles the user's fills,
+ *     expires what is left of the user's orders and advances to the next timestamp
+ *   - runToEnd() steps until the book's last timestamp has been matched
+ *   - attachAccounts(manager) settles other traders' fills into a WalletManager
+ * MerkelMain drives it from the menu; the headless replay tool drives it from a script.
+ */
+class Simulation
+{
+    public:
+    /** What one step() did. `sales` views the step's sales and is valid until the next step. */
+        struct StepResult
+        {
+            std::string timestamp;                 // the timestamp that was matched
+            std::span<const OrderBookEntry> sales; // every sale, all products and users
+            Wallet::SettlementReport settlement;   // the user's fills applied to the wallet
+            size_t queuedPlaced = 0;               // queued orders entered by this step
+            size_t queuedRejected = 0;             // queued orders their owner couldn't cover
+            size_t accountFills = 0;               // other traders' sales settled into accounts
+            bool wrapped = false;                  // true if that was the last timestamp
+        };
+    /** Running totals since construction. */
+        struct Stats
+        {
+            size_t timesteps = 0;
+            size_t sales = 0;
+            size_t userFills = 0;
+            size_t accountFills = 0;
+            size_t ordersPlaced = 0;
+            size_t ordersRejected = 0;
+            double volume = 0.0;    // sum of sale amounts
+        };
+
+        Simulation(OrderBook& book, Wallet& wallet, std::string username = "simuser",
+                   size_t queueCapacity = 4096);
+
+    /** The timestamp the next step() will match. */
+        const std::string& currentTime() const;
+    /** Enter an order for the user at the current time; false if the wallet can't cover it. */
+        bool placeOrder(OrderBookEntry order);
+    /**
+     * Any thread: queue an order for the next step(), which stamps it with that step's
+     * time. An order still named "dataset" is taken to be the user's and goes through
+     * the wallet like placeOrder(); one already carrying another trader's name (e.g. a
+     * simulated trader) is entered as market liquidity. False if the queue is full.
+     */
+        bool submitOrder(OrderBookEntry order);
+    /** Settle other traders' sales into `accounts` (and check their orders) from now on. */
+        void attachAccounts(WalletManager& accounts);
+    /** Name stamped on the user's orders. */
+        const std::string& userName() const { return username; }
+    /** Match, settle and advance one timestamp. */
+        StepResult step();
+    /** Step until the last timestamp has been matched; returns the number of steps taken. */
+        size_t runToEnd();
+        const Stats& stats() const;
+
+    private:
+    /** Enter everything queued by submitOrder(), as one batch. */
+        void drainQueue(StepResult& result);
+
+        OrderBook&               orderBook;
+        Wallet&                  wallet;
+        WalletManager*           accounts = nullptr;   // other traders, if attached
+        std::string              username;
+        std::string              current;
+        std::vector<std::string> products;   // products matched each step
+        OrderArena               matchArena; // scratch for matching, reset every step
+        std::vector<std::unique_ptr<OrderArena>> productArenas; // per-product scratch for parallel matching
+        OrderQueue               ingress;    // orders submitted from any thread
+        std::vector<OrderBookEntry> drained; // scratch for drainQueue, reused every step
+        Stats                    totals;
+};
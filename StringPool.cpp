@@ -0,0 +1,116 @@
+#include "StringPool.h"
+#include <cstring>
+#include <algorithm>
+
+/**
+ * StringPool:
+ *   Interns strings into large, never-freed blocks. Order book data repeats the same few
+ *   strings (a timestamp for hundreds of rows in a row, a handful of products, one username),
+ *   so after a string's first sighting every later use is just a view into the pool.
+ */
+
+/**
+ * Constructor
+ * @param blockSize  Size of each block requested from the global allocator.
+ *                   Strings longer than this get a block of their own.
+ */
+StringPool::StringPool(size_t _blockSize)
+: blockSize(_blockSize),
+  used(0),
+  counters{0, 0, 0}
+{
+}
+
+/**
+ * intern
+ * Returns the pooled copy of `s`, storing it first if it has not been seen before.
+ *
+ * @param s  Any string; it does not need to outlive the call.
+ * @return A view whose characters live in this pool and compare equal to `s`.
+ *
+ * Behavior:
+ *   1. Checks a small per-thread cache of recently interned views. Consecutive rows
+ *      mostly repeat the same timestamp/product/username, so this usually hits and
+ *      returns without taking the lock.
+ *   2. Otherwise looks `s` up in the index under the mutex, storing a new copy on a miss.
+ *   3. Remembers the result in the per-thread cache (round-robin replacement).
+ */
+PooledString StringPool::intern(std::string_view s)
+{
+    struct CacheSlot
+    {
+        const StringPool* pool = nullptr;
+        std::string_view view;
+    };
+    constexpr size_t CACHE_SLOTS = 8;
+    thread_local CacheSlot cache[CACHE_SLOTS];
+    thread_local size_t nextSlot = 0;
+
+    // 1) Per-thread cache: no lock, no hashing
+    for (const auto& slot : cache) {
+        if (slot.pool == this && slot.view == s) {
+            return PooledString{slot.view};
+        }
+    }
+
+    // 2) Shared index
+    std::string_view pooled;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto it = index.find(s);
+        if (it != index.end()) {
+            pooled = *it;
+        } else {
+            pooled = store(s);
+            index.insert(pooled);
+        }
+    }
+
+    // 3) Remember it for this thread
+    cache[nextSlot] = CacheSlot{this, pooled};
+    nextSlot = (nextSlot + 1) % CACHE_SLOTS;
+    return PooledString{pooled};
+}
+
+/**
+ * store
+ * Copies `s` into the current block (starting a new block if it does not fit).
+ * Caller must hold `mutex`.
+ */
+std::string_view StringPool::store(std::string_view s)
+{
+    if (blocks.empty() || used + s.size() > blockSize) {
+        blocks.push_back(std::make_unique<char[]>(std::max(blockSize, s.size())));
+        used = 0;
+        ++counters.blocks;
+    }
+
+    char* dest = blocks.back().get() + used;
+    std::memcpy(dest, s.data(), s.size());
+    used += s.size();
+
+    counters.bytes += s.size();
+    ++counters.strings;
+    return std::string_view{dest, s.size()};
+}
+
+/**
+ * stats
+ * Returns the number of blocks allocated and strings/bytes stored so far.
+ */
+StringPool::Stats StringPool::stats() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return counters;
+}
+
+/**
+ * shared
+ * The process-wide pool. Constructed on first use and never destroyed, so views into it
+ * stay valid even during static destruction.
+ */
+StringPool& StringPool::shared()
+{
+    static StringPool* pool = new StringPool();
+    return *pool;
+}
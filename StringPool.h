@@ -0,0 +1,86 @@
+#pragma once
+
+#include <compare>
+#include <ostream>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+/**
+ * PooledString: a view of a string held by a StringPool.
+ *   - only StringPool::intern makes a non-empty one, so it can never dangle, and equal
+ *     strings from one pool share one pointer (which pointer-keyed caches rely on)
+ *   - reads like a std::string_view and converts to one implicitly
+ */
+class PooledString
+{
+    public:
+    /** The empty string. */
+        constexpr PooledString() = default;
+
+        operator std::string_view() const { return view; }
+        std::string_view str() const { return view; }
+        const char* data() const { return view.data(); }
+        size_t size() const { return view.size(); }
+        bool empty() const { return view.empty(); }
+        auto begin() const { return view.begin(); }
+        auto end() const { return view.end(); }
+        char operator[](size_t i) const { return view[i]; }
+        std::string_view substr(size_t pos, size_t count = std::string_view::npos) const
+        {
+            return view.substr(pos, count);
+        }
+
+        friend bool operator==(PooledString a, PooledString b) { return a.view == b.view; }
+        friend bool operator==(PooledString a, std::string_view b) { return a.view == b; }
+        friend std::strong_ordering operator<=>(PooledString a, PooledString b) { return a.view <=> b.view; }
+        friend std::strong_ordering operator<=>(PooledString a, std::string_view b) { return a.view <=> b; }
+        friend std::ostream& operator<<(std::ostream& out, PooledString s) { return out << s.view; }
+
+    private:
+        friend class StringPool;
+        explicit PooledString(std::string_view pooled) : view(pooled) {}
+
+        std::string_view view;
+};
+/**
+ * StringPool: an append-only arena of interned strings.
+ *   - intern(s) returns a view of a pooled copy of s; equal strings share one copy
+ *   - copies are packed into large blocks, so there is no heap allocation per string
+ *   - views stay valid for the lifetime of the pool (shared() lives for the whole program)
+ *   - stats() exposes how many blocks/strings the pool has allocated
+ */
+class StringPool
+{
+    public:
+    /** Allocation counters, for checking that hot paths stay off the global allocator. */
+        struct Stats
+        {
+            size_t blocks;   // blocks requested from the global allocator
+            size_t bytes;    // bytes of string data stored
+            size_t strings;  // distinct strings interned
+        };
+
+        explicit StringPool(size_t blockSize = 64 * 1024);
+        StringPool(const StringPool&) = delete;
+        StringPool& operator=(const StringPool&) = delete;
+
+    /** Return the pooled copy of `s`, adding it on first sight. Thread-safe. */
+        [[nodiscard]] PooledString intern(std::string_view s);
+    /** Snapshot of the allocation counters. */
+        Stats stats() const;
+    /** The process-wide pool used by OrderBookEntry. */
+        static StringPool& shared();
+
+    private:
+        std::string_view store(std::string_view s);
+
+        size_t blockSize;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        size_t used;                          // bytes used in blocks.back()
+        std::unordered_set<std::string_view> index;
+        Stats counters;
+        mutable std::mutex mutex;
+};
@@ -0,0 +1,286 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+/**
+ * TaskScheduler:
+ *   The deques are guarded by one small mutex each; contention is low because a worker
+ *   normally only touches its own, and thieves only look elsewhere when theirs is
+ *   empty. `queued` counts tasks across all deques so idle workers can sleep on one
+ *   condition variable instead of spinning over every deque.
+ */
+
+namespace
+{
+    // Which scheduler / worker the calling thread belongs to (-1: not a worker)
+    thread_local const TaskScheduler* tlsScheduler = nullptr;
+    thread_local int tlsWorker = -1;
+
+    std::mutex sharedMutex;
+    TaskScheduler::Options sharedOptions;
+    bool sharedStarted = false;
+
+    /** Pin the calling thread to one CPU; a no-op where that is not supported. */
+    void pinToCpu(size_t cpu)
+    {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<int>(cpu % CPU_SETSIZE), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+        SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << (cpu % (sizeof(DWORD_PTR) * 8)));
+#else
+        (void)cpu;
+#endif
+    }
+}
+
+/**
+ * Constructor
+ * Starts the workers (at least one); with pinThreads, worker i runs only on CPU
+ * i mod hardware_concurrency().
+ */
+TaskScheduler::TaskScheduler(Options options)
+{
+    size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+    size_t count = options.workers ? options.workers : cpus;
+
+    workers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < count; ++i) {
+        workers[i]->thread = std::thread(&TaskScheduler::run, this, i, options.pinThreads);
+    }
+}
+
+TaskScheduler::TaskScheduler()
+: TaskScheduler(Options{})
+{
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) {
+        w->thread.join();
+    }
+}
+
+/** Index of the calling thread among this scheduler's workers, or -1. */
+int TaskScheduler::currentWorker() const
+{
+    return (tlsScheduler == this) ? tlsWorker : -1;
+}
+
+/**
+ * submit
+ * A worker pushes onto its own deque (the task is likely to use what it just
+ * touched); any other thread deals tasks round-robin. Then wakes one sleeper.
+ */
+void TaskScheduler::submit(std::function<void()> task)
+{
+    int self = currentWorker();
+    size_t target = (self >= 0) ? static_cast<size_t>(self)
+                                : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    {
+        // Taking the lock orders this notify after a sleeper's predicate check
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+/**
+ * take
+ * Pops the newest task of worker `self` (if `self` is a worker index), else steals the
+ * oldest task of the first non-empty deque after it.
+ */
+bool TaskScheduler::take(size_t self, std::function<void()>& task)
+{
+    const size_t n = workers.size();
+    if (self < n) {
+        Worker& own = *workers[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    for (size_t k = 1; k <= n; ++k) {
+        size_t victim = (self + k) % n;
+        if (victim == self) {
+            continue;
+        }
+        Worker& other = *workers[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * run
+ * Worker loop: run own tasks, then stolen ones; sleep while there is nothing queued.
+ * On shutdown the deques are emptied before the worker exits.
+ */
+void TaskScheduler::run(size_t index, bool pin)
+{
+    tlsScheduler = this;
+    tlsWorker = static_cast<int>(index);
+    if (pin) {
+        pinToCpu(index);
+    }
+
+    std::function<void()> task;
+    for (;;) {
+        if (take(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping && queued.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void TaskScheduler::configure(Options options)
+{
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (!sharedStarted) {
+        sharedOptions = options;
+    }
+}
+
+/**
+ * shared
+ * Created on first use from configure()'s options; MERKEL_WORKERS / MERKEL_PIN_THREADS
+ * fill in whatever configure() left at its default. Never destroyed, so tasks still
+ * queued at exit cannot outlive it.
+ */
+TaskScheduler& TaskScheduler::shared()
+{
+    static TaskScheduler* instance = [] {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        Options options = sharedOptions;
+        if (options.workers == 0) {
+            if (const char* env = std::getenv("MERKEL_WORKERS")) {
+                options.workers = std::strtoull(env, nullptr, 10);
+            }
+        }
+        if (!options.pinThreads) {
+            if (const char* env = std::getenv("MERKEL_PIN_THREADS")) {
+                options.pinThreads = std::string(env) == "1";
+            }
+        }
+        sharedStarted = true;
+        return new TaskScheduler(options);
+    }();
+    return *instance;
+}
+
+TaskGroup::TaskGroup(TaskScheduler& _scheduler)
+: scheduler(_scheduler),
+  state(std::make_shared<State>())
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    try {
+        wait();
+    } catch (...) {
+        // An unobserved task failure; nothing sensible to do with it in a destructor
+    }
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->tasks.push_back(std::move(task));
+        ++state->unfinished;
+    }
+    scheduler.submit([state = state] { runNext(*state); });
+}
+
+/**
+ * runNext
+ * Runs the oldest task of the group, recording its exception if it throws, and wakes
+ * the waiter when it was the last unfinished one.
+ */
+bool TaskGroup::runNext(State& state)
+{
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.tasks.empty()) {
+            return false;
+        }
+        task = std::move(state.tasks.front());
+        state.tasks.pop_front();
+    }
+
+    std::exception_ptr failure;
+    try {
+        task();
+    } catch (...) {
+        failure = std::current_exception();
+    }
+    task = nullptr;   // release what it captured before the waiter returns
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (failure && !state.error) {
+        state.error = failure;
+    }
+    if (--state.unfinished == 0) {
+        state.done.notify_all();
+    }
+    return true;
+}
+
+/**
+ * wait
+ * Runs the group's tasks that no worker has started yet on the calling thread, then
+ * sleeps until the ones running elsewhere have finished.
+ */
+void TaskGroup::wait()
+{
+    while (runNext(*state)) {
+    }
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [this] { return state->unfinished == 0; });
+    if (state->error) {
+        std::exception_ptr e = std::exchange(state->error, nullptr);
+        std::rethrow_exception(e);
+    }
+}
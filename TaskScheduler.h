@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * TaskScheduler: one work-stealing thread pool for the whole program.
+ *   - every worker owns a deque: it pushes and pops its own tasks at the back (newest
+ *     first, cache-warm) and, when it runs dry, steals the oldest task from the front
+ *     of another worker's deque, so uneven work (one big product, one big file)
+ *     spreads across the idle workers
+ *   - tasks submitted from outside the pool are dealt round-robin to the workers
+ *   - TaskGroup runs a batch of tasks and waits for them; the waiting thread runs the
+ *     group's own not-yet-started tasks itself meanwhile (never anyone else's), so
+ *     nested groups never tie up a worker
+ *   - shared() is sized by configure(), or by the MERKEL_WORKERS (count) and
+ *     MERKEL_PIN_THREADS (1 = pin worker i to CPU i) environment variables
+ * Ingest (file loading, CSV parsing, sorting), matching and the menu's background
+ * analytics all run here, so the number of busy threads stays bounded.
+ */
+class TaskScheduler
+{
+    public:
+        struct Options
+        {
+            size_t workers = 0;        // 0 = one per hardware thread
+            bool pinThreads = false;   // pin worker i to CPU i (mod the CPU count)
+        };
+
+    /** One worker per hardware thread, unpinned. */
+        TaskScheduler();
+        explicit TaskScheduler(Options options);
+    /** Lets the workers finish every queued task, then joins them. */
+        ~TaskScheduler();
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /** Queue a task (fire and forget); exceptions escaping it terminate the program. */
+        void submit(std::function<void()> task);
+        size_t workerCount() const { return workers.size(); }
+    /** Tasks taken from another worker's deque so far. */
+        size_t stealCount() const { return steals.load(std::memory_order_relaxed); }
+
+    /** Set the shared scheduler's options; only has an effect before its first use. */
+        static void configure(Options options);
+    /** The process-wide scheduler, started on first use. */
+        static TaskScheduler& shared();
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+            std::thread thread;
+        };
+
+        void run(size_t index, bool pin);
+        bool take(size_t self, std::function<void()>& task);
+        int currentWorker() const;
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<size_t> queued{0};        // tasks in all deques
+        std::atomic<size_t> nextWorker{0};    // round-robin target for outside submits
+        std::atomic<size_t> steals{0};
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        bool stopping = false;
+};
+
+/**
+ * TaskGroup: fork-join on a TaskScheduler.
+ *   run(task) queues a task; wait() returns once every task run so far has finished,
+ *   rethrowing the first exception one of them threw. The destructor waits too.
+ *   The group keeps its tasks in a queue of its own and gives the scheduler one ticket
+ *   per task; a ticket runs the group's next task, if any is left. So wait() can run
+ *   the group's remaining tasks on the calling thread, and then sleeps until the ones
+ *   other threads picked up have finished, without ever running unrelated work
+ *   (e.g. a background chart job while the menu waits for matching).
+ */
+class TaskGroup
+{
+    public:
+        explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::shared());
+        ~TaskGroup();
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void run(std::function<void()> task);
+        void wait();
+
+    private:
+    /** Shared with the tickets, which may outlive the group (their task already taken). */
+        struct State
+        {
+            std::mutex mutex;
+            std::condition_variable done;
+            std::deque<std::function<void()>> tasks;   // not yet started
+            size_t unfinished = 0;                      // queued or running
+            std::exception_ptr error;
+        };
+
+    /** Take and run the group's next task; false if none was left. */
+        static bool runNext(State& state);
+
+        TaskScheduler& scheduler;
+        std::shared_ptr<State> state;
+};
@@ -1,198 +1,272 @@
-#include "TextPlotter.h"
-#include <iostream>
-#include <algorithm>
-#include <iomanip>
-
-/**
- * TextPlotter:
- *   Provides static methods to render various data (candlesticks, volume, mean price)
- *   as text-based (ASCII) charts in the console.
- */
-
-/**
- * drawCandlesticks
- * Renders an ASCII candlestick chart for a series of Candlestick objects.
- *
- * @param candles  A vector of Candlestick objects, each containing:
- *                   - timestamp (string, "YYYY/MM/DD HH:MM:SS.ffffff")
- *                   - open, high, low, close (doubles)
- *
- * Behavior:
- *   1. If `candles` is empty, prints "No data to plot" and returns.
- *   2. Determines the global high and low prices across all candles.
- *   3. Divides the price range into a fixed number of rows (20 by default).
- *   4. For each row (top to bottom), computes the price level and:
- *        - Prints the price label on the left (with fixed precision).
- *        - For each candle:
- *            • Prints '*' if the level lies between open and close (the "body").
- *            • Prints '|' if the level lies between low and high but outside the body (the "wick").
- *            • Otherwise prints a space.
- *   5. After drawing all rows, prints a horizontal axis of '-' characters.
- *   6. Prints timestamp labels (HH:MM:SS) every LABEL_EVERY candles beneath the axis.
- */
-void TextPlotter::drawCandlesticks(const std::vector<Candlestick>& candles) {
-    // 1) Handle empty input
-    if (candles.empty()) {
-        std::cout << "No data to plot\n";
-        return;
-    }
-
-    // 2) Determine global high and low across all candles
-    double globalHigh = candles.front().high;
-    double globalLow  = candles.front().low;
-    for (const auto& c : candles) {
-        globalHigh = std::max(globalHigh, c.high);
-        globalLow  = std::min(globalLow,  c.low);
-    }
-
-    // 3) Chart dimensions and scaling
-    const int rows = 20;                                // number of horizontal rows
-    double rawSpan = globalHigh - globalLow;            // price span
-    // If all prices equal, avoid division by zero by using span = 1
-    double span = (rawSpan == 0.0 ? 1.0 : rawSpan) / rows;
-
-    // 4) Formatting for price labels on left
-    const int PREC = 6;           // show 6 decimal places (e.g., 0.024723)
-    const int WID  = PREC + 3;    // enough width to display "-0.xxxxxx"
-
-    // 5) Draw each row from top (highest price) down to bottom (lowest price)
-    for (int r = rows; r >= 0; --r) {
-        double level = globalLow + r * span;  // price level corresponding to this row
-
-        // Print the price label, right-aligned in a field of width WID
-        std::cout << std::setw(WID)
-                  << std::fixed << std::setprecision(PREC)
-                  << level << " |";
-
-        // For each candle, decide if this level is in the body or wick
-        for (const auto& c : candles) {
-            bool inWhisker = (c.low <= level && level <= c.high);
-            bool inBody    = ((c.open <= level && level <= c.close) ||
-                              (c.close <= level && level <= c.open));
-
-            if (inBody)
-                std::cout << '*';     // within the candle's body (open-close)
-            else if (inWhisker)
-                std::cout << '|';     // within the candle's wick (low-high, outside body)
-            else
-                std::cout << ' ';     // no candle at this level
-        }
-
-        std::cout << '\n';  // end of this row
-    }
-
-    // 6) Draw the horizontal X-axis using '-' characters
-    //    Align under the chart area (WID + 3 spaces for "level |")
-    std::cout << std::string(WID + 3, ' ')
-              << std::string(candles.size(), '-') << "\n";
-
-    // 7) Print timestamp labels (every LABEL_EVERY candles)
-    const size_t LABEL_EVERY = 5;   // print a label for every 5th candle
-    const int    LABW        = 8;   // width of "HH:MM:SS" (8 characters)
-
-    // Align under the chart area again
-    std::cout << std::string(WID + 3, ' ');
-    for (size_t i = 0; i < candles.size(); ++i) {
-        if (i % LABEL_EVERY == 0) {
-            // Extract the HH:MM:SS portion from "YYYY/MM/DD HH:MM:SS.ffffff"
-            std::cout << candles[i].timestamp.substr(11, LABW);
-        } else {
-            std::cout << std::string(LABW, ' ');
-        }
-    }
-    std::cout << '\n';
-}
-
-/**
- * drawVolumeChart
- * Renders a simple text-based bar chart of trading volume over time.
- *
- * @param vol  A vector of (timestamp, volume) pairs, where:
- *               - timestamp: string ("YYYY/MM/DD HH:MM:SS.ffffff")
- *               - volume:     double (sum of amounts at that timestamp)
- *
- * Behavior:
- *   1. If `vol` is empty, prints "No volume data" and returns.
- *   2. Finds the maximum volume value among all pairs.
- *   3. For each (ts, v):
- *        - Computes `len = floor((v / maxV) * 50)`.
- *        - Prints "ts | " followed by `len` asterisks ('*') to represent relative volume.
- *        - Then prints " (v)" showing the actual volume number.
- */
-void TextPlotter::drawVolumeChart(
-    const std::vector<std::pair<std::string,double>>& vol)
-{
-    // 1) Handle empty input
-    if (vol.empty()) {
-        std::cout << "No volume data\n";
-        return;
-    }
-
-    // 2) Determine the maximum volume value for normalization
-    double maxV = 0.0;
-    for (auto const& [ts, v] : vol) {
-        maxV = std::max(maxV, v);
-    }
-
-    // 3) For each timestamp, print a bar of '*' proportional to (v / maxV)
-    for (auto const& [ts, v] : vol) {
-        int len = static_cast<int>((v / maxV) * 50);  // scale to max 50 stars
-        std::cout << ts << " | ";
-        for (int i = 0; i < len; ++i) {
-            std::cout << '*';
-        }
-        // Print the actual volume in parentheses
-        std::cout << " (" << v << ")\n";
-    }
-}
-
-/**
- * drawMeanPriceChart
- * Renders a text-based bar chart of average (mean) prices per time bucket (e.g., per minute).
- *
- * @param data  A vector of (timeBucket, avgPrice) pairs, where:
- *                - timeBucket: string like "HH:MM"
- *                - avgPrice:   double (rounded to 6 decimals)
- *
- * Behavior:
- *   1. If `data` is empty, prints "No mean price data." and returns.
- *   2. Finds the minimum and maximum average prices across all buckets.
- *   3. For each (minute, avg):
- *        - Computes `frac = (avg - minP) / (maxP - minP)` in [0,1].
- *        - Computes `len = floor(frac * 50)` to scale into 0–50 stars.
- *        - Prints "minute | " followed by `len` asterisks ('*'), then " (avg)" showing the price.
- *
- * If all average prices are identical (maxP == minP), `span` is set to 1.0 to avoid division by zero.
- */
-void TextPlotter::drawMeanPriceChart(
-    const std::vector<std::pair<std::string, double>>& data)
-{
-    // 1) Handle empty input
-    if (data.empty()) {
-        std::cout << "No mean price data.\n";
-        return;
-    }
-
-    // 2) Find the global min and max among all average prices
-    double minP = data.front().second;
-    double maxP = data.front().second;
-    for (auto const& [_, avg] : data) {
-        minP = std::min(minP, avg);
-        maxP = std::max(maxP, avg);
-    }
-
-    // Use span = (maxP - minP), or 1.0 if all are equal to avoid division by zero
-    double span = (maxP == minP ? 1.0 : (maxP - minP));
-
-    // 3) For each time bucket, normalize and print a bar of '*' proportional to its position in [minP,maxP]
-    for (auto const& [minute, avg] : data) {
-        double frac = (avg - minP) / span;                 // normalized [0,1]
-        int len    = static_cast<int>(frac * 50);          // scale to [0,50]
-        std::cout << minute << " | ";
-        for (int i = 0; i < len; ++i) {
-            std::cout << '*';
-        }
-        // Print the actual average price to 6 decimal places
-        std::cout << " (" << std::fixed << std::setprecision(6) << avg << ")\n";
-    }
-}
+#include "TextPlotter.h"
+#include "Decimator.h"
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * TextPlotter:
+ *   Provides static methods to render various data (candlesticks, volume, mean price)
+ *   as text-based (ASCII) charts in the console.
+ */
+
+/**
+ * drawCandlesticks
+ * Renders an ASCII candlestick chart for a series of Candlestick objects.
+ *
+ * @param candles  A vector of Candlestick objects, each containing:
+ *                   - timestamp (string, "YYYY/MM/DD HH:MM:SS.ffffff")
+ *                   - open, high, low, close (doubles)
+ *
+ * Behavior:
+ *   1. If `candles` is empty, prints "No data to plot" and returns.
+ *      If there are more candles than fit in `maxColumns` (0 = terminal width minus
+ *      the label column), adjacent candles are merged (Decimator::mergeCandles).
+ *   2. Determines the global high and low prices across all candles.
+ *   3. Divides the price range into a fixed number of rows (20 by default) and
+ *      computes each row's price level once.
+ *   4. Allocates the whole frame (label column, one column per candle, axis and
+ *      timestamp line) as one blank character grid.
+ *   5. For each candle, finds by binary search over the row levels the rows its wick
+ *      (low..high) and body (open..close) cover, and fills that column: '*' for body,
+ *      '|' for wick outside the body. Cells no candle covers stay blank.
+ *   6. Writes each row's price label (fixed precision) on the left, a horizontal axis
+ *      of '-' characters, and a timestamp label (HH:MM:SS) under every LABEL_EVERY-th
+ *      candle, aligned with its column.
+ *   7. Emits the grid with a single write.
+ */
+void TextPlotter::drawCandlesticks(const std::vector<Candlestick>& allCandles, size_t maxColumns) {
+    // 1) Handle empty input
+    if (allCandles.empty()) {
+        std::cout << "No data to plot\n";
+        return;
+    }
+    //    Fit the series to the screen: one column per (possibly merged) candle
+    if (maxColumns == 0) {
+        const size_t reserved = 24;   // price label column plus room for the last timestamp
+        maxColumns = std::max<size_t>(terminalColumns(), reserved + 10) - reserved;
+    }
+    const std::vector<Candlestick> candles = Decimator::mergeCandles(allCandles, maxColumns);
+
+    // 2) Determine global high and low across all candles
+    double globalHigh = candles.front().high;
+    double globalLow  = candles.front().low;
+    for (const auto& c : candles) {
+        globalHigh = std::max(globalHigh, c.high);
+        globalLow  = std::min(globalLow,  c.low);
+    }
+
+    // 3) Chart dimensions and scaling
+    const int rows = 20;                                // number of horizontal rows
+    double rawSpan = globalHigh - globalLow;            // price span
+    // If all prices equal, avoid division by zero by using span = 1
+    double span = (rawSpan == 0.0 ? 1.0 : rawSpan) / rows;
+
+    // Price level of each row, bottom (r = 0) to top (r = rows); ascending
+    std::vector<double> levels(rows + 1);
+    for (int r = 0; r <= rows; ++r) {
+        levels[r] = globalLow + r * span;
+    }
+
+    // 4) Formatting for price labels on left, and the frame layout
+    const int PREC = 6;           // show 6 decimal places (e.g., 0.024723)
+    const int WID  = PREC + 3;    // enough width to display "-0.xxxxxx"
+    const size_t LABEL_EVERY = 10;  // a timestamp label under every 10th candle
+    const size_t LABW        = 8;   // width of "HH:MM:SS" (8 characters)
+
+    // Price labels, right-aligned in a field of at least WID (wider if a price needs it)
+    std::vector<std::string> labels(rows + 1);
+    size_t labelWidth = WID;
+    char label[64];
+    for (int r = 0; r <= rows; ++r) {
+        int n = std::snprintf(label, sizeof label, "%*.*f", WID, PREC, levels[r]);
+        labels[r].assign(label, static_cast<size_t>(n));
+        labelWidth = std::max(labelWidth, labels[r].size());
+    }
+
+    const size_t left  = labelWidth + 2;          // "<label> |"
+    const size_t width = left + candles.size() + LABW + 1;   // room for the last label, plus '\n'
+    const size_t lines = (rows + 1) + 2;          // price rows, axis, timestamps
+    std::string grid(width * lines, ' ');
+    for (size_t line = 0; line < lines; ++line) {
+        grid[line * width + width - 1] = '\n';
+    }
+    // Grid line of row r (row `rows` is drawn first, at the top)
+    auto lineOf = [&](int r) { return static_cast<size_t>(rows - r) * width; };
+
+    // 5) One column per candle: fill its wick and body row ranges
+    for (size_t i = 0; i < candles.size(); ++i) {
+        const auto& c = candles[i];
+        double bodyLow  = std::min(c.open, c.close);
+        double bodyHigh = std::max(c.open, c.close);
+
+        // Rows whose level lies in [low, high] (wick) and [bodyLow, bodyHigh] (body)
+        int wickFrom = static_cast<int>(std::lower_bound(levels.begin(), levels.end(), c.low) - levels.begin());
+        int wickTo   = static_cast<int>(std::upper_bound(levels.begin(), levels.end(), c.high) - levels.begin());
+        int bodyFrom = static_cast<int>(std::lower_bound(levels.begin(), levels.end(), bodyLow) - levels.begin());
+        int bodyTo   = static_cast<int>(std::upper_bound(levels.begin(), levels.end(), bodyHigh) - levels.begin());
+
+        size_t col = left + i;
+        for (int r = wickFrom; r < wickTo; ++r) {
+            grid[lineOf(r) + col] = '|';     // within the candle's wick (low-high)
+        }
+        for (int r = bodyFrom; r < bodyTo; ++r) {
+            grid[lineOf(r) + col] = '*';     // within the candle's body (open-close)
+        }
+    }
+
+    // 6) Price labels on the left of each row, then " |"
+    for (int r = 0; r <= rows; ++r) {
+        size_t pad = labelWidth - labels[r].size();
+        grid.replace(lineOf(r) + pad, labels[r].size(), labels[r]);
+        grid[lineOf(r) + labelWidth + 1] = '|';
+    }
+
+    //    Horizontal X-axis under the chart area
+    size_t axis = static_cast<size_t>(rows + 1) * width;
+    std::fill_n(grid.begin() + axis + left, candles.size(), '-');
+
+    //    Timestamp labels: HH:MM:SS from "YYYY/MM/DD HH:MM:SS.ffffff", under their candle
+    size_t stamps = axis + width;
+    for (size_t i = 0; i < candles.size(); i += LABEL_EVERY) {
+        const std::string& ts = candles[i].timestamp;
+        if (ts.size() > 11) {
+            size_t len = std::min(LABW, ts.size() - 11);
+            grid.replace(stamps + left + i, len, ts, 11, len);
+        }
+    }
+
+    // 7) One write for the whole frame
+    std::cout.write(grid.data(), static_cast<std::streamsize>(grid.size()));
+}
+
+/**
+ * drawVolumeChart
+ * Renders a simple text-based bar chart of trading volume over time.
+ *
+ * @param vol  A vector of (timestamp, volume) pairs, where:
+ *               - timestamp: string ("YYYY/MM/DD HH:MM:SS.ffffff")
+ *               - volume:     double (sum of amounts at that timestamp)
+ *
+ * Behavior:
+ *   1. If `vol` is empty, prints "No volume data" and returns.
+ *      If it has more points than `maxRows` (0 = terminal height), it is reduced
+ *      to each span's min and max (Decimator::minMax), so spikes stay visible.
+ *   2. Finds the maximum volume value among all pairs.
+ *   3. For each (ts, v):
+ *        - Computes `len = floor((v / maxV) * 50)`.
+ *        - Prints "ts | " followed by `len` asterisks ('*') to represent relative volume.
+ *        - Then prints " (v)" showing the actual volume number.
+ */
+void TextPlotter::drawVolumeChart(
+    const std::vector<std::pair<std::string,double>>& allVol, size_t maxRows)
+{
+    // 1) Handle empty input
+    if (allVol.empty()) {
+        std::cout << "No volume data\n";
+        return;
+    }
+    const auto vol = Decimator::minMax(allVol, maxRows ? maxRows : terminalRows());
+
+    // 2) Determine the maximum volume value for normalization
+    double maxV = 0.0;
+    for (auto const& [ts, v] : vol) {
+        maxV = std::max(maxV, v);
+    }
+
+    // 3) For each timestamp, print a bar of '*' proportional to (v / maxV)
+    for (auto const& [ts, v] : vol) {
+        int len = static_cast<int>((v / maxV) * 50);  // scale to max 50 stars
+        std::cout << ts << " | ";
+        for (int i = 0; i < len; ++i) {
+            std::cout << '*';
+        }
+        // Print the actual volume in parentheses
+        std::cout << " (" << v << ")\n";
+    }
+}
+
+/**
+ * drawMeanPriceChart
+ * Renders a text-based bar chart of average (mean) prices per time bucket (e.g., per minute).
+ *
+ * @param data  A vector of (timeBucket, avgPrice) pairs, where:
+ *                - timeBucket: string like "HH:MM"
+ *                - avgPrice:   double (rounded to 6 decimals)
+ *
+ * Behavior:
+ *   1. If `data` is empty, prints "No mean price data." and returns.
+ *      If it has more points than `maxRows` (0 = terminal height), LTTB picks the
+ *      points that best keep the shape of the price line (Decimator::lttb).
+ *   2. Finds the minimum and maximum average prices across all buckets.
+ *   3. For each (minute, avg):
+ *        - Computes `frac = (avg - minP) / (maxP - minP)` in [0,1].
+ *        - Computes `len = floor(frac * 50)` to scale into 0–50 stars.
+ *        - Prints "minute | " followed by `len` asterisks ('*'), then " (avg)" showing the price.
+ *
+ * If all average prices are identical (maxP == minP), `span` is set to 1.0 to avoid division by zero.
+ */
+void TextPlotter::drawMeanPriceChart(
+    const std::vector<std::pair<std::string, double>>& allData, size_t maxRows)
+{
+    // 1) Handle empty input
+    if (allData.empty()) {
+        std::cout << "No mean price data.\n";
+        return;
+    }
+    const auto data = Decimator::lttb(allData, maxRows ? maxRows : terminalRows());
+
+    // 2) Find the global min and max among all average prices
+    double minP = data.front().second;
+    double maxP = data.front().second;
+    for (auto const& [_, avg] : data) {
+        minP = std::min(minP, avg);
+        maxP = std::max(maxP, avg);
+    }
+
+    // Use span = (maxP - minP), or 1.0 if all are equal to avoid division by zero
+    double span = (maxP == minP ? 1.0 : (maxP - minP));
+
+    // 3) For each time bucket, normalize and print a bar of '*' proportional to its position in [minP,maxP]
+    for (auto const& [minute, avg] : data) {
+        double frac = (avg - minP) / span;                 // normalized [0,1]
+        int len    = static_cast<int>(frac * 50);          // scale to [0,50]
+        std::cout << minute << " | ";
+        for (int i = 0; i < len; ++i) {
+            std::cout << '*';
+        }
+        // Print the actual average price to 6 decimal places
+        std::cout << " (" << std::fixed << std::setprecision(6) << avg << ")\n";
+    }
+}
+
+namespace
+{
+    size_t envSize(const char* name, size_t fallback)
+    {
+        const char* value = std::getenv(name);
+        if (value == nullptr) {
+            return fallback;
+        }
+        char* end = nullptr;
+        unsigned long n = std::strtoul(value, &end, 10);
+        return (end != value && n > 0) ? static_cast<size_t>(n) : fallback;
+    }
+}
+
+/**
+ * terminalColumns / terminalRows
+ * Size of the output area from $COLUMNS / $LINES (set by most shells), falling back
+ * to 120 x 60 when they are missing or not numbers.
+ */
+size_t TextPlotter::terminalColumns()
+{
+    return envSize("COLUMNS", 120);
+}
+
+size_t TextPlotter::terminalRows()
+{
+    return envSize("LINES", 60);
+}
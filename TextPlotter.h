@@ -1,37 +1,46 @@
-#pragma once
-#include <vector>
-#include <string>
-#include <utility>
-#include "Candlestick.h"
-/**
- * TextPlotter: contains static methods to render ASCII charts:
- *   1) drawCandlesticks(...) – candlestick chart of OHLC data
- *   2) drawVolumeChart(...) – bar chart of volume (timestamp, amount)
- *   3) drawMeanPriceChart(...) – bar chart of average price per minute
- */
-class TextPlotter {
-public:
-    /**
-     * Render a text‐based candlestick chart:
-     *   - '|' for whisks (if price level between low and high)
-     *   - '*' for body (if level between open and close)
-     *   - Rows are price levels (20 rows total)
-     *   - Columns are successive candles
-     */
-    // Draw a text‐based candlestick chart
-    static void drawCandlesticks(const std::vector<Candlestick>& candles);
-    /**
-         * Render a text‐based bar chart of volume:
-         *   - For each (timestamp, amount): draw `len = (amount / maxAmount)*50` stars
-         */
-    // Draw a text‐based bar chart of volume (timestamp, amount)
-    static void drawVolumeChart(
-  const std::vector<std::pair<std::string,double>>& vol);
-    /**
-     * Render a text‐based bar chart of mean price per minute:
-     *   - Input: vector of (minuteLabel, avgPrice)
-     *   - Normalize across the day’s [minAvg, maxAvg], then scale to 0..50 stars
-     */
-    static void drawMeanPriceChart(const std::vector<std::pair<std::string, double>>& prices);
-
-};
+#pragma once
+#include <vector>
+#include <string>
+#include <utility>
+#include "Candlestick.h"
+/**
+ * TextPlotter: contains static methods to render ASCII charts:
+ *   1) drawCandlesticks(...) – candlestick chart of OHLC data
+ *   2) drawVolumeChart(...) – bar chart of volume (timestamp, amount)
+ *   3) drawMeanPriceChart(...) – bar chart of average price per minute
+ * Series longer than the screen are first reduced by Decimator (candles merged,
+ * volume bars by min/max, mean price by LTTB), so output is bounded by the
+ * terminal size ($COLUMNS / $LINES, or 120 x 60) rather than the data size.
+ */
+class TextPlotter {
+public:
+    /**
+     * Render a text‐based candlestick chart:
+     *   - '|' for whisks (if price level between low and high)
+     *   - '*' for body (if level between open and close)
+     *   - Rows are price levels (20 rows total)
+     *   - Columns are successive candles, merged to at most `maxColumns` (0 = terminal width)
+     */
+    // Draw a text‐based candlestick chart
+    static void drawCandlesticks(const std::vector<Candlestick>& candles, size_t maxColumns = 0);
+    /**
+         * Render a text‐based bar chart of volume:
+         *   - For each (timestamp, amount): draw `len = (amount / maxAmount)*50` stars
+         *   - At most `maxRows` bars (0 = terminal height), keeping each span's min and max
+         */
+    // Draw a text‐based bar chart of volume (timestamp, amount)
+    static void drawVolumeChart(
+  const std::vector<std::pair<std::string,double>>& vol, size_t maxRows = 0);
+    /**
+     * Render a text‐based bar chart of mean price per minute:
+     *   - Input: vector of (minuteLabel, avgPrice)
+     *   - Normalize across the day’s [minAvg, maxAvg], then scale to 0..50 stars
+     *   - At most `maxRows` bars (0 = terminal height), picked by LTTB
+     */
+    static void drawMeanPriceChart(const std::vector<std::pair<std::string, double>>& prices,
+                                   size_t maxRows = 0);
+    /** Terminal width / height in characters ($COLUMNS / $LINES, else 120 / 60). */
+    static size_t terminalColumns();
+    static size_t terminalRows();
+
+};
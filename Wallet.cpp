@@ -1,6 +1,9 @@
 #include "Wallet.h"
+#include "Metrics.h"
+#include "Logger.h"
+#include "StringPool.h"
 #include <iostream>
-#include "CSVReader.h"
+#include <algorithm>
 
 /**
  * Wallet:
@@ -15,7 +18,7 @@
  */
 Wallet::Wallet()
 {
-    // Initially, the `currencies` map is empty. No further setup needed.
+    // Initially, the balance table is empty. No further setup needed.
 }
 
 /**
@@ -28,26 +31,19 @@ Wallet::Wallet()
  * @throws std::exception if `amount` is negative.
  *
  * Behavior:
- *   - If `type` does not exist in the `currencies` map, it initializes its balance to 0.
+ *   - Looks up the currency's ID; a currency never seen before starts at 0.
  *   - Adds `amount` to the existing balance for `type`.
  *   - If `amount` < 0, an exception is thrown.
  */
-void Wallet::insertCurrency(std::string type, double amount)
+void Wallet::insertCurrency(const std::string& type, double amount)
 {
     if (amount < 0) {
         // Negative deposit is not allowed.
         throw std::exception{};
     }
 
-    double balance = 0.0;
-    // Check if this currency already exists in the map.
-    if (currencies.count(type) > 0) {
-        balance = currencies[type];  // existing balance
-    }
-    // Increase balance by the deposit amount.
-    balance += amount;
-    // Update (or create) the entry in the map.
-    currencies[type] = balance;
+    // Increase (or create) the balance by the deposit amount.
+    balanceOf(CurrencyRegistry::shared().idOf(type)) += amount;
 }
 
 /**
@@ -62,24 +58,26 @@ void Wallet::insertCurrency(std::string type, double amount)
  * Behavior:
  *   - If `amount` is negative, returns false (invalid).
  *   - If `type` is not present in the wallet, returns false.
- *   - If the wallet has at least `amount` of `type`, subtract it and return true.
+ *   - If the wallet has at least `amount` of `type` available (not reserved for open
+ *     orders), subtract it and return true.
  *   - Otherwise (insufficient funds), return false.
  */
-bool Wallet::removeCurrency(std::string type, double amount)
+bool Wallet::removeCurrency(const std::string& type, double amount)
 {
     if (amount < 0) {
         // Cannot remove a negative amount.
         return false;
     }
 
-    // If currency is not in the wallet at all, cannot remove.
-    if (currencies.count(type) == 0) {
+    // One lookup: a currency not in the wallet has no slot (or a 0 balance)
+    CurrencyId id = CurrencyRegistry::shared().idOf(type);
+    if (id >= balances.size() || !held[id]) {
         return false;
     }
 
-    // If there is enough balance, subtract and return true.
-    if (containsCurrency(type, amount)) {
-        currencies[type] -= amount;
+    // If there is enough unreserved balance, subtract and return true.
+    if (available(id) >= amount) {
+        balances[id] -= amount;
         return true;
     }
 
@@ -89,21 +87,23 @@ bool Wallet::removeCurrency(std::string type, double amount)
 
 /**
  * containsCurrency
- * Checks if the wallet has at least `amount` of `type` currency.
+ * Checks if the wallet has at least `amount` of `type` currency available,
+ * i.e. not already reserved for open orders.
  *
  * @param type   The currency ticker to check (e.g., "BTC", "ETH").
  * @param amount The required amount.
  *
- * @return true if wallet[type] >= amount, false otherwise.
+ * @return true if wallet[type] - reserved[type] >= amount, false otherwise.
  */
-bool Wallet::containsCurrency(std::string type, double amount)
+bool Wallet::containsCurrency(const std::string& type, double amount)
 {
-    // If currency is not in the wallet map, balance is effectively zero.
-    if (currencies.count(type) == 0) {
+    // If currency is not in the wallet, balance is effectively zero.
+    CurrencyId id = CurrencyRegistry::shared().idOf(type);
+    if (id >= balances.size() || !held[id]) {
         return false;
     }
-    // Otherwise, compare stored balance to requested amount.
-    return currencies[type] >= amount;
+    // Otherwise, compare the unreserved balance to the requested amount.
+    return available(id) >= amount;
 }
 
 /**
@@ -111,23 +111,34 @@ bool Wallet::containsCurrency(std::string type, double amount)
  * Generates a multi-line string representation of the entire wallet.
  *
  * Format:
- *   <CURRENCY> : <AMOUNT>\n
- *   <CURRENCY> : <AMOUNT>\n
+ *   <CURRENCY> : <AMOUNT>[ (reserved <RESERVED>)]\n
+ *   <CURRENCY> : <AMOUNT>[ (reserved <RESERVED>)]\n
  *   ...
  *
  * Example:
  *   "BTC : 0.500000\nETH : 10.000000\nUSDT : 250.000000\n"
  *
- * @return A std::string containing each currency and its balance.
+ * @return A std::string containing each currency and its balance, sorted by currency name.
  */
 std::string Wallet::toString()
 {
+    // Collect held currencies by name so the listing stays alphabetical
+    std::vector<std::pair<std::string, CurrencyId>> rows;
+    for (CurrencyId id = 0; id < balances.size(); ++id) {
+        if (held[id]) {
+            rows.emplace_back(CurrencyRegistry::shared().nameOf(id), id);
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+
     std::string s;
-    for (auto const& pair : currencies) {
-        const std::string& currency = pair.first;
-        double amount = pair.second;
-        // Append "currency : amount\n"
-        s += currency + " : " + std::to_string(amount) + "\n";
+    for (auto const& [currency, id] : rows) {
+        // Append "currency : amount\n", noting any part reserved for open orders
+        s += currency + " : " + std::to_string(balances[id]);
+        if (reserved[id] > 0.0) {
+            s += " (reserved " + std::to_string(reserved[id]) + ")";
+        }
+        s += "\n";
     }
     return s;
 }
@@ -137,41 +148,47 @@ std::string Wallet::toString()
  * Determines if the wallet has sufficient funds to place a given order.
  *
  * Orders in this exchange are always of the form "BASE/QUOTE", e.g. "ETH/USDT".
- *   - For an ask (sell), the user must have at least `amount` of BASE currency.
- *   - For a bid (buy), the user must have at least `amount * price` of QUOTE currency.
+ *   - For an ask (sell), the user must have at least `amount` of BASE currency available.
+ *   - For a bid (buy), the user must have at least `amount * price` of QUOTE currency available.
+ *   "Available" excludes funds reserved for other open orders (see reserveOrder), so
+ *   several open orders cannot commit the same funds twice.
  *
  * @param order The OrderBookEntry to check against the wallet’s balances.
  *
  * @return true if the wallet can cover the order, false if not.
  *
  * Behavior:
- *   - Tokenizes the product string `BASE/QUOTE` into ["BASE","QUOTE"].
+ *   - Gets the (BASE, QUOTE) IDs of the product from the per-wallet cache
+ *     (the product string is only split the first time it is seen).
  *   - If orderType == ask:
  *       Need `amount` units of BASE.
  *   - If orderType == bid:
  *       Need `amount * price` units of QUOTE.
  */
-bool Wallet::canFulfillOrder(OrderBookEntry order)
+bool Wallet::canFulfillOrder(const OrderBookEntry& order)
 {
-    // Split the product "BASE/QUOTE" into two tokens.
-    std::vector<std::string> currs = CSVReader::tokenise(order.product, '/');
+    // Look up the product's BASE and QUOTE currency IDs.
+    CurrencyRegistry::ProductCurrencies currs;
+    if (!productCurrencies.lookup(order.product, currs)) {
+        return false;
+    }
 
-    // If this is a sell order (ask), check if we have enough BASE (currs[0]).
+    // If this is a sell order (ask), check if we have enough BASE.
     if (order.orderType == OrderBookType::ask) {
         double amountNeeded = order.amount;       // amount of BASE to sell
-        std::string baseCurrency = currs[0];
-        std::cout << "Wallet::canFulfillOrder " << baseCurrency
-                  << " : " << amountNeeded << std::endl;
-        return containsCurrency(baseCurrency, amountNeeded);
+        LOG_DEBUG("Wallet::canFulfillOrder " << CurrencyRegistry::shared().nameOf(currs.base)
+                  << " : " << amountNeeded);
+        return currs.base < balances.size() && held[currs.base] &&
+               available(currs.base) >= amountNeeded;
     }
 
-    // If this is a buy order (bid), check if we have enough QUOTE (currs[1]).
+    // If this is a buy order (bid), check if we have enough QUOTE.
     if (order.orderType == OrderBookType::bid) {
         double quoteNeeded = order.amount * order.price;  // amount of QUOTE to pay
-        std::string quoteCurrency = currs[1];
-        std::cout << "Wallet::canFulfillOrder " << quoteCurrency
-                  << " : " << quoteNeeded << std::endl;
-        return containsCurrency(quoteCurrency, quoteNeeded);
+        LOG_DEBUG("Wallet::canFulfillOrder " << CurrencyRegistry::shared().nameOf(currs.quote)
+                  << " : " << quoteNeeded);
+        return currs.quote < balances.size() && held[currs.quote] &&
+               available(currs.quote) >= quoteNeeded;
     }
 
     // For any other order type, we cannot fulfill it.
@@ -191,36 +208,306 @@ bool Wallet::canFulfillOrder(OrderBookEntry order)
  *         wallet[BASE]  += sale.amount;
  *         wallet[QUOTE] -= sale.amount * sale.price;
  *
+ * If funds were reserved for the order this sale filled (same timestamp, product and
+ * side), the currency paid out is taken from that reservation: for an ask the BASE sold,
+ * for a bid the filled share of the QUOTE reserved at the bid price. Anything left over
+ * (e.g. because the fill was at a lower ask price) stays reserved until the order is
+ * cancelled or expired.
+ *
  * @param sale The OrderBookEntry representing a sale. Its orderType is asksale or bidsale.
  */
-void Wallet::processSale(OrderBookEntry& sale)
+void Wallet::processSale(const OrderBookEntry& sale)
 {
-    // Split "BASE/QUOTE" into ["BASE","QUOTE"].
-    std::vector<std::string> currs = CSVReader::tokenise(sale.product, '/');
+    MERKEL_TIMED_SCOPE("Wallet::processSale");
+    // Look up the product's BASE and QUOTE currency IDs.
+    CurrencyRegistry::ProductCurrencies currs;
+    if (!productCurrencies.lookup(sale.product, currs)) {
+        return;
+    }
+
+    // Consume the reservation held for the order that was filled, if any
+    OrderBookType side = (sale.orderType == OrderBookType::asksale) ? OrderBookType::ask
+                                                                     : OrderBookType::bid;
+    consumeReservation(OrderKey{sale.timestamp.data(), sale.product.data(), side}, sale.amount);
 
     // If this sale is from an ask (user sold BASE):
     if (sale.orderType == OrderBookType::asksale) {
         double baseSold    = sale.amount;                // amount of BASE sold
-        std::string base   = currs[0];                   // e.g., "ETH"
-        double quoteGained = sale.amount * sale.price;   // USD received
-        std::string quote  = currs[1];                   // e.g., "USDT"
+        double quoteGained = sale.amount * sale.price;   // QUOTE received
 
         // Increase QUOTE balance, decrease BASE balance.
-        currencies[quote] += quoteGained;
-        currencies[base]  -= baseSold;
+        balanceOf(currs.quote) += quoteGained;
+        balanceOf(currs.base)  -= baseSold;
     }
 
     // If this sale is from a bid (user bought BASE):
     if (sale.orderType == OrderBookType::bidsale) {
         double baseGained  = sale.amount;                // amount of BASE bought
-        std::string base   = currs[0];                   // e.g., "ETH"
-        double quoteSpent  = sale.amount * sale.price;   // USD spent
-        std::string quote  = currs[1];                   // e.g., "USDT"
+        double quoteSpent  = sale.amount * sale.price;   // QUOTE spent
 
         // Increase BASE balance, decrease QUOTE balance.
-        currencies[base]  += baseGained;
-        currencies[quote] -= quoteSpent;
+        balanceOf(currs.base)  += baseGained;
+        balanceOf(currs.quote) -= quoteSpent;
+    }
+}
+
+/**
+ * settle
+ * Applies a whole timestep's sales in one pass.
+ *
+ * @param sales     Every sale produced by matching (all products, all users).
+ * @param username  Only sales whose username equals this are applied to this wallet.
+ * @return          A report of how many fills were applied and the net change per currency.
+ *
+ * Behavior:
+ *   - Same effect on balances and reservations as calling processSale for each of the
+ *     user's sales, but the per-currency deltas are summed into a scratch array first
+ *     and each touched currency's balance is updated once at the end.
+ *   - Consecutive fills of the same product reuse its base/quote IDs, and consecutive
+ *     fills of the same order (timestamp, product, side) are summed before its
+ *     reservation is looked up, so a heavy timestep costs a hash lookup per product or
+ *     order run plus O(currencies) of balance work, not a few lookups per fill.
+ *   - Sales for products that are not "BASE/QUOTE" are skipped.
+ */
+Wallet::SettlementReport Wallet::settle(std::span<const OrderBookEntry> sales, std::string_view username)
+{
+    MERKEL_TIMED_SCOPE("Wallet::settle");
+    SettlementReport report;
+    if (netDelta.size() < CurrencyRegistry::shared().size()) {
+        netDelta.resize(CurrencyRegistry::shared().size(), 0.0);
+    }
+
+    const char* lastProduct = nullptr;
+    CurrencyRegistry::ProductCurrencies currs{};
+    bool productOk = false;
+    OrderKey runKey{nullptr, nullptr, OrderBookType::unknown};
+    double runFilled = 0.0;
+
+    for (const OrderBookEntry& sale : sales) {
+        if (sale.username != username) {
+            continue;
+        }
+        if (sale.product.data() != lastProduct) {
+            lastProduct = sale.product.data();
+            productOk = productCurrencies.lookup(sale.product, currs);
+            if (productOk && std::max(currs.base, currs.quote) >= netDelta.size()) {
+                netDelta.resize(std::max(currs.base, currs.quote) + 1, 0.0);
+            }
+        }
+        if (!productOk) {
+            continue;
+        }
+
+        double quote = sale.amount * sale.price;
+        OrderBookType side;
+        if (sale.orderType == OrderBookType::asksale) {
+            netDelta[currs.base]  -= sale.amount;   // user sold BASE
+            netDelta[currs.quote] += quote;
+            side = OrderBookType::ask;
+        } else if (sale.orderType == OrderBookType::bidsale) {
+            netDelta[currs.base]  += sale.amount;   // user bought BASE
+            netDelta[currs.quote] -= quote;
+            side = OrderBookType::bid;
+        } else {
+            continue;
+        }
+        ++report.fills;
+
+        // Sum fills of the same order; settle its reservation when the run ends
+        OrderKey key{sale.timestamp.data(), sale.product.data(), side};
+        if (!(key == runKey)) {
+            if (runKey.product) {
+                consumeReservation(runKey, runFilled);
+            }
+            runKey = key;
+            runFilled = 0.0;
+        }
+        runFilled += sale.amount;
+    }
+    if (runKey.product) {
+        consumeReservation(runKey, runFilled);
+    }
+
+    // One balance update per touched currency; leave the scratch array zeroed
+    for (CurrencyId id = 0; id < netDelta.size(); ++id) {
+        if (netDelta[id] != 0.0) {
+            balanceOf(id) += netDelta[id];
+            report.net.emplace_back(id, netDelta[id]);
+            netDelta[id] = 0.0;
+        }
+    }
+    return report;
+}
+
+/**
+ * SettlementReport::toString
+ * Formats the report on one line: fill count, then each currency's signed net change.
+ */
+std::string Wallet::SettlementReport::toString() const
+{
+    std::string s = std::to_string(fills) + " fills";
+    const char* sep = ": ";
+    for (auto const& [id, delta] : net) {
+        s += sep;
+        s += CurrencyRegistry::shared().nameOf(id);
+        s += delta >= 0.0 ? " +" : " ";
+        s += std::to_string(delta);
+        sep = ", ";
+    }
+    return s;
+}
+
+/**
+ * consumeReservation
+ * Draws a fill of `filled` (BASE amount) off the reservation recorded for `key`:
+ * releases the matching share of the reserved funds, and drops the record once the
+ * order is completely filled. Does nothing if the order had no reservation.
+ */
+void Wallet::consumeReservation(const OrderKey& key, double filled)
+{
+    auto open = openOrders.find(key);
+    if (open == openOrders.end()) {
+        return;
+    }
+    Reservation& r = open->second;
+    filled = std::min(filled, r.openAmount);
+    double share = (r.openAmount > 0.0) ? r.reserved * filled / r.openAmount : 0.0;
+    release(r.currency, share);
+    r.reserved   -= share;
+    r.openAmount -= filled;
+    if (r.openAmount <= 0.0) {
+        release(r.currency, r.reserved);
+        openOrders.erase(open);
+    }
+}
+
+/**
+ * reserveOrder
+ * Commits the funds an order needs, so later checks see them as unavailable.
+ *
+ * @param order  A user ask or bid.
+ * @return true if the funds were available and are now reserved; false otherwise
+ *         (nothing is reserved).
+ *
+ * Behavior:
+ *   - Same requirement as canFulfillOrder: `amount` BASE for an ask,
+ *     `amount * price` QUOTE for a bid, checked against the available balance.
+ *   - Adds it to the currency's reserved total and to the open-order record for
+ *     (timestamp, product, side), which fills and cancellations draw down.
+ */
+bool Wallet::reserveOrder(const OrderBookEntry& order)
+{
+    MERKEL_TIMED_SCOPE("Wallet::reserveOrder");
+    if (!canFulfillOrder(order)) {
+        return false;
+    }
+
+    CurrencyRegistry::ProductCurrencies currs;
+    productCurrencies.lookup(order.product, currs);
+    bool isAsk = (order.orderType == OrderBookType::ask);
+    CurrencyId currency = isAsk ? currs.base : currs.quote;
+    double amount       = isAsk ? order.amount : order.amount * order.price;
+
+    balanceOf(currency);            // make sure the currency has a slot
+    reserved[currency] += amount;
+
+    Reservation& r = openOrders.try_emplace(
+        OrderKey{order.timestamp.data(), order.product.data(), order.orderType},
+        Reservation{currency, 0.0, 0.0}).first->second;
+    r.reserved   += amount;
+    r.openAmount += order.amount;
+    return true;
+}
+
+/**
+ * cancelOrder
+ * Frees what is still reserved for a cancelled order.
+ *
+ * @param order  The order as it was reserved (same timestamp, product, side, price, amount).
+ *
+ * Behavior:
+ *   - Releases the order's share of its open-order record: its unfilled amount, and
+ *     the matching proportion of the reserved funds. Does nothing if it was never
+ *     reserved or has been filled completely.
+ */
+void Wallet::cancelOrder(const OrderBookEntry& order)
+{
+    consumeReservation(OrderKey{order.timestamp.data(), order.product.data(), order.orderType},
+                       order.amount);
+}
+
+/**
+ * expireOrders
+ * Releases every reservation of orders placed at `timestamp`. Orders only match at
+ * their own timestamp, so once the simulation moves past it they can no longer fill.
+ *
+ * @param timestamp  The timestamp the orders were placed at.
+ *
+ * Behavior:
+ *   - Keys hold pooled timestamp pointers, so `timestamp` is interned once and keys
+ *     are compared by pointer (exact match, never reading past a stored string).
+ */
+void Wallet::expireOrders(std::string_view timestamp)
+{
+    const char* pooled = StringPool::shared().intern(timestamp).data();
+    for (auto it = openOrders.begin(); it != openOrders.end(); ) {
+        if (it->first.timestamp == pooled) {
+            release(it->second.currency, it->second.reserved);
+            it = openOrders.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * reservedCurrency
+ * Returns how much of `type` is currently committed to open orders.
+ */
+double Wallet::reservedCurrency(const std::string& type)
+{
+    CurrencyId id = CurrencyRegistry::shared().idOf(type);
+    return id < reserved.size() ? reserved[id] : 0.0;
+}
+
+/**
+ * available
+ * Balance minus reserved funds for one currency (0 if the wallet has no slot for it).
+ */
+double Wallet::available(CurrencyId id) const
+{
+    if (id >= balances.size()) {
+        return 0.0;
+    }
+    return balances[id] - reserved[id];
+}
+
+/**
+ * release
+ * Returns up to `amount` of reserved funds to the available balance (floored at 0,
+ * so rounding never leaves a negative reservation).
+ */
+void Wallet::release(CurrencyId id, double amount)
+{
+    if (id < reserved.size()) {
+        reserved[id] = std::max(0.0, reserved[id] - amount);
+    }
+}
+
+/**
+ * balanceOf
+ * Returns the balance slot for a currency ID, growing the table to cover it.
+ * Marks the currency as held, so it shows up in toString() even at 0.
+ */
+double& Wallet::balanceOf(CurrencyId id)
+{
+    if (id >= balances.size()) {
+        balances.resize(id + 1, 0.0);
+        reserved.resize(id + 1, 0.0);
+        held.resize(id + 1, 0);
     }
+    held[id] = 1;
+    return balances[id];
 }
 
 /**
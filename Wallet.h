@@ -1,8 +1,13 @@
 #pragma once
 
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <utility>
+#include <unordered_map>
 #include "OrderBookEntry.h"
+#include "CurrencyRegistry.h"
 #include <iostream>
 /**
  * Wallet: keeps track of multiple currency balances.
@@ -10,26 +15,55 @@
  *   - removeCurrency(type, amount) to deduct
  *   - containsCurrency(type, amount) to check sufficiency
  *   - canFulfillOrder(order) to see if wallet can pay that ask/bid
+ *   - reserveOrder / cancelOrder / expireOrders to commit and free funds for open orders
  *   - processSale(order) to update balances when a sale completes
+ *   - settle(sales, user) to apply a whole timestep's sales at once, netted per currency
  *   - toString() to view current holdings
+ *
+ * Each currency has a total balance and a reserved part (committed to open orders);
+ * checks use the available part (total - reserved), which is kept up to date
+ * incrementally, so they stay O(1) however many orders are open.
+ *
+ * Balances are a flat array indexed by CurrencyId (see CurrencyRegistry), and each
+ * product's base/quote IDs are cached the first time the wallet sees that product,
+ * so order checks and sale updates are a hash lookup plus a couple of array reads.
  */
 class Wallet 
 {
     public:
+        /** What settle() applied: fills counted and the net change per currency. */
+        struct SettlementReport
+        {
+            size_t fills = 0;                                   // sales applied
+            std::vector<std::pair<CurrencyId, double>> net;     // ascending CurrencyId, non-zero only
+            /** One line, e.g. "3 fills: BTC -0.060000, ETH +3.000000". */
+            std::string toString() const;
+        };
+
         Wallet();
         /** insert currency to the wallet */
-        void insertCurrency(std::string type, double amount);
+        void insertCurrency(const std::string& type, double amount);
         /** remove currency from the wallet */
-        bool removeCurrency(std::string type, double amount);
+        bool removeCurrency(const std::string& type, double amount);
         
-        /** check if the wallet contains this much currency or more */
-        bool containsCurrency(std::string type, double amount);
-        /** checks if the wallet can cope with this ask or bid.*/
-        bool canFulfillOrder(OrderBookEntry order);
+        /** check if the wallet has this much currency or more available (not reserved) */
+        bool containsCurrency(const std::string& type, double amount);
+        /** checks if the wallet can cope with this ask or bid from its available funds.*/
+        bool canFulfillOrder(const OrderBookEntry& order);
+        /** reserve the funds this ask/bid needs; false (nothing reserved) if unavailable */
+        bool reserveOrder(const OrderBookEntry& order);
+        /** release what is still reserved for this order (it was cancelled) */
+        void cancelOrder(const OrderBookEntry& order);
+        /** release every reservation of orders placed at `timestamp` (they can no longer match) */
+        void expireOrders(std::string_view timestamp);
+        /** amount of a currency committed to open orders */
+        double reservedCurrency(const std::string& type);
         /** update the contents of the wallet
          * assumes the order was made by the owner of the wallet
         */
-        void processSale(OrderBookEntry& sale);
+        void processSale(const OrderBookEntry& sale);
+        /** apply every sale in `sales` that belongs to `username`, one balance update per currency */
+        SettlementReport settle(std::span<const OrderBookEntry> sales, std::string_view username);
 
 
         /** generate a string representation of the wallet */
@@ -38,7 +72,49 @@ class Wallet
 
         
     private:
-        std::map<std::string,double> currencies;
+        /** Balance slot for `id`, growing the table if needed. Marks the currency as held. */
+        double& balanceOf(CurrencyId id);
+        /** Balance minus reservations for `id` (0 for a currency never held). */
+        double available(CurrencyId id) const;
+        /** Release up to `amount` of reserved `id` (never below zero). */
+        void release(CurrencyId id, double amount);
+
+        /**
+         * Funds reserved for the open orders sharing one (timestamp, product, side).
+         * Keys use the entries' pooled string pointers.
+         */
+        struct OrderKey
+        {
+            const char* timestamp;
+            const char* product;
+            OrderBookType side;
+            bool operator==(const OrderKey& o) const = default;
+        };
+        struct OrderKeyHash
+        {
+            size_t operator()(const OrderKey& k) const
+            {
+                size_t h = std::hash<const void*>{}(k.timestamp);
+                h ^= std::hash<const void*>{}(k.product) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+                return h ^ static_cast<size_t>(k.side);
+            }
+        };
+        struct Reservation
+        {
+            CurrencyId currency;  // BASE for asks, QUOTE for bids
+            double reserved;      // amount of `currency` still held back
+            double openAmount;    // unfilled order amount (in BASE) still covered
+        };
+
+        /** Draw `filled` (BASE amount) off the reservation for `key`, releasing its share. */
+        void consumeReservation(const OrderKey& key, double filled);
+
+        std::vector<double> balances;   // indexed by CurrencyId
+        std::vector<double> reserved;   // indexed by CurrencyId; part of balances held back
+        std::vector<char>   held;       // held[id] != 0 once the currency was ever touched
+        std::unordered_map<OrderKey, Reservation, OrderKeyHash> openOrders;
+        std::vector<double> netDelta;   // settle() scratch, indexed by CurrencyId
+        ProductCurrencyCache productCurrencies;   // BASE/QUOTE of each product seen
 
 };
 
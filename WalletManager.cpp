@@ -0,0 +1,207 @@
+#include "WalletManager.h"
+#include "StringPool.h"
+#include <algorithm>
+
+/**
+ * WalletManager:
+ *   Holds the balances of every simulated trader in one flat table, so replaying
+ *   thousands of accounts touches contiguous memory rather than thousands of maps.
+ *   Row = account, column = CurrencyId.
+ */
+
+/**
+ * Default constructor
+ * Starts with no accounts and room for 8 currencies per row (widened on demand).
+ */
+WalletManager::WalletManager()
+: stride(8)
+{
+}
+
+/**
+ * openAccount
+ * Returns the account for `username`, appending a new all-zero row if it is new.
+ * The pointer cache is keyed by the name's pooled copy (StringPool), never by the
+ * caller's buffer, so a temporary string cannot leave a dangling key behind.
+ */
+AccountId WalletManager::openAccount(std::string_view username)
+{
+    AccountId account;
+    if (findAccount(username, account)) {
+        return account;
+    }
+
+    account = static_cast<AccountId>(names.size());
+    names.emplace_back(username);
+    byName.emplace(names.back(), account);
+    byPointer.emplace(StringPool::shared().intern(username).data(), account);
+    table.resize(table.size() + stride, 0.0);
+    return account;
+}
+
+/**
+ * findAccount
+ * Looks up the account of `username`.
+ *
+ * Behavior:
+ *   - First tries the pointer cache, which holds only pooled name pointers. Entry
+ *     usernames are pooled, so all of one user's orders hit it; pooled memory is never
+ *     freed, so no other buffer can share such an address. A hit costs one pointer
+ *     hash plus a length check (guarding against a view of a prefix of the same
+ *     characters).
+ *   - On a miss (e.g. a caller's own std::string), looks the name up by content.
+ */
+bool WalletManager::findAccount(std::string_view username, AccountId& out)
+{
+    auto fast = byPointer.find(username.data());
+    if (fast != byPointer.end() && names[fast->second].size() == username.size()) {
+        out = fast->second;
+        return true;
+    }
+
+    auto it = byName.find(username);
+    if (it == byName.end()) {
+        return false;
+    }
+    out = it->second;
+    return true;
+}
+
+/**
+ * accountCount
+ * Number of accounts opened so far (IDs are 0 .. accountCount()-1).
+ */
+size_t WalletManager::accountCount() const
+{
+    return names.size();
+}
+
+/**
+ * accountName
+ * Username the account was opened with.
+ */
+const std::string& WalletManager::accountName(AccountId account) const
+{
+    return names[account];
+}
+
+/**
+ * deposit
+ * Adds `amount` (may be negative) to one currency of one account, immediately.
+ */
+void WalletManager::deposit(AccountId account, CurrencyId currency, double amount)
+{
+    table[slot(account, currency)] += amount;
+}
+
+/**
+ * balance
+ * Returns one account's balance in one currency (0 for currencies never touched).
+ */
+double WalletManager::balance(AccountId account, CurrencyId currency) const
+{
+    if (currency >= stride) {
+        return 0.0;
+    }
+    return table[account * stride + currency];
+}
+
+/**
+ * canFulfillOrder
+ * Checks an account can cover an order, as Wallet::canFulfillOrder does:
+ *   - ask: needs `amount` of BASE
+ *   - bid: needs `amount * price` of QUOTE
+ * @return false for other order types or malformed products.
+ */
+bool WalletManager::canFulfillOrder(AccountId account, const OrderBookEntry& order)
+{
+    CurrencyRegistry::ProductCurrencies currs;
+    if (!productCurrencies.lookup(order.product, currs)) {
+        return false;
+    }
+    if (order.orderType == OrderBookType::ask) {
+        return balance(account, currs.base) >= order.amount;
+    }
+    if (order.orderType == OrderBookType::bid) {
+        return balance(account, currs.quote) >= order.amount * order.price;
+    }
+    return false;
+}
+
+/**
+ * queueSale
+ * Routes a sale to its owner's account and queues the resulting balance changes.
+ *
+ * @param sale  An asksale or bidsale whose `username` names the trading account.
+ * @return true if the sale belonged to a known account and was queued.
+ *
+ * Behavior:
+ *   - asksale: QUOTE += amount * price, BASE -= amount
+ *   - bidsale: BASE += amount, QUOTE -= amount * price
+ *   - Nothing is applied until applyPending().
+ */
+bool WalletManager::queueSale(const OrderBookEntry& sale)
+{
+    AccountId account;
+    CurrencyRegistry::ProductCurrencies currs;
+    if (!findAccount(sale.username, account) || !productCurrencies.lookup(sale.product, currs)) {
+        return false;
+    }
+
+    double quote = sale.amount * sale.price;
+    if (sale.orderType == OrderBookType::asksale) {
+        pending.push_back(Delta{slot(account, currs.quote),  quote});
+        pending.push_back(Delta{slot(account, currs.base),  -sale.amount});
+        return true;
+    }
+    if (sale.orderType == OrderBookType::bidsale) {
+        pending.push_back(Delta{slot(account, currs.base),   sale.amount});
+        pending.push_back(Delta{slot(account, currs.quote), -quote});
+        return true;
+    }
+    return false;
+}
+
+/**
+ * applyPending
+ * Applies every queued balance change in one pass and clears the queue
+ * (its capacity is kept for the next timestep).
+ *
+ * @return The number of balance changes applied.
+ */
+size_t WalletManager::applyPending()
+{
+    for (const auto& d : pending) {
+        table[d.index] += d.delta;
+    }
+    size_t applied = pending.size();
+    pending.clear();
+    return applied;
+}
+
+/**
+ * slot
+ * Returns the table index of (account, currency). If the currency ID does not fit in
+ * the current row width, doubles the width and re-lays out the table (rare: once per
+ * doubling of the number of currencies). Queued deltas are re-pointed accordingly.
+ */
+size_t WalletManager::slot(AccountId account, CurrencyId currency)
+{
+    if (currency >= stride) {
+        size_t wider = stride;
+        while (currency >= wider) {
+            wider *= 2;
+        }
+
+        std::vector<double> relaid(names.size() * wider, 0.0);
+        for (size_t a = 0; a < names.size(); ++a) {
+            std::copy_n(table.begin() + a * stride, stride, relaid.begin() + a * wider);
+        }
+        for (auto& d : pending) {
+            d.index = (d.index / stride) * wider + d.index % stride;
+        }
+        table  = std::move(relaid);
+        stride = wider;
+    }
+    return account * stride + currency;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "OrderBookEntry.h"
+#include "CurrencyRegistry.h"
+/**
+ * Dense numeric ID of a simulated trading account, assigned by WalletManager.
+ */
+using AccountId = std::uint32_t;
+
+/**
+ * WalletManager: balances for many simulated traders in one contiguous table.
+ *   - openAccount(username) registers a trader and returns its AccountId
+ *   - balances are a row-major [account][currency] table of doubles
+ *   - sales are routed to their owner's account by username in O(1) (cached by the
+ *     pooled username pointer) and queued; applyPending() applies a timestep's queue
+ *     as one batch
+ */
+class WalletManager
+{
+    public:
+        WalletManager();
+
+    /** Return the account for `username`, creating an empty one if needed. */
+        AccountId openAccount(std::string_view username);
+    /** Find the account of `username`. Returns false if it has none. */
+        bool findAccount(std::string_view username, AccountId& out);
+    /** Number of accounts. */
+        size_t accountCount() const;
+    /** Username of an account. */
+        const std::string& accountName(AccountId account) const;
+
+    /** Add (or, with a negative amount, remove) funds directly. */
+        void deposit(AccountId account, CurrencyId currency, double amount);
+    /** Current balance of one currency in one account (0 if never touched). */
+        double balance(AccountId account, CurrencyId currency) const;
+    /** Same check as Wallet::canFulfillOrder, for one account. */
+        bool canFulfillOrder(AccountId account, const OrderBookEntry& order);
+
+    /**
+     * Queue the balance changes of a sale for the account named in sale.username.
+     * Sales by users without an account are ignored (returns false).
+     */
+        bool queueSale(const OrderBookEntry& sale);
+    /** Apply every queued change and clear the queue. Returns how many were applied. */
+        size_t applyPending();
+
+    private:
+    /** One queued balance change: `delta` to table[index]. */
+        struct Delta
+        {
+            size_t index;
+            double delta;
+        };
+
+    /** Lets `byName` be searched with a string_view without building a std::string. */
+        struct NameHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+        };
+
+    /** Index of (account, currency) in `table`, widening the rows if the currency is new. */
+        size_t slot(AccountId account, CurrencyId currency);
+
+        std::vector<double> table;   // accounts × stride balances, row-major
+        size_t stride;               // currency columns per account row
+        std::vector<std::string> names;
+        std::unordered_map<std::string, AccountId, NameHash, std::equal_to<>> byName;
+        std::unordered_map<const char*, AccountId> byPointer;   // pooled name pointer → account
+        ProductCurrencyCache productCurrencies;   // BASE/QUOTE of each product seen
+        std::vector<Delta> pending;
+};
@@ -0,0 +1,231 @@
+#include "CSVReader.h"
+#include "Logger.h"
+#include "OrderArena.h"
+#include "OrderBook.h"
+#include "OrderBookEntry.h"
+#include "OrderFlowGenerator.h"
+#include "Wallet.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * exchange_alloc_check: counts heap allocations on the ingest, order-entry and matching
+ * paths and fails (exit code 1) if they copy strings per row again, or if matching
+ * allocates once its arena is warm.
+ *
+ * Usage:
+ *   exchange_alloc_check [--rows N]
+ *
+ * Every global operator new (aligned ones included) is counted. The checks:
+ *   readCSV          allocations per row of a generated CSV must stay well under one, and
+ *                    far below the old path (a std::string per line, a vector of std::string
+ *                    tokens, and the fields copied again into stringsToOBE's parameters)
+ *   stringsToOBE     converting views of strings already in the pool allocates nothing
+ *   canFulfillOrder  on a product the wallet has seen allocates nothing
+ *   matchAsksToBids  into an OrderArena warmed on every timestamp of the book: a second
+ *                    pass over them makes no global allocation, and the arena none either
+ */
+
+namespace
+{
+    std::atomic<size_t> allocations{0};
+}
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// Over-aligned requests (OrderArena's upstream resource uses them) count as well
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = std::max(static_cast<size_t>(align), sizeof(void*));
+    size = (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+    void* p = _aligned_malloc(size, alignment);
+#else
+    void* p = std::aligned_alloc(alignment, size);
+#endif
+    if (p) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t align) noexcept
+{
+    operator delete(p, align);
+}
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    size_t allocated()
+    {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    /** The old signature: every field arrives as its own std::string copy. */
+    OrderBookEntry legacyStringsToOBE(std::string price, std::string amount, std::string timestamp,
+                                      std::string product, std::string type)
+    {
+        return CSVReader::stringsToOBE(price, amount, timestamp, product,
+                                       OrderBookEntry::stringToOrderBookType(type));
+    }
+
+    /** Rows of `path` parsed the way readCSV did before it worked on views. */
+    size_t legacyRead(const std::string& path, std::vector<OrderBookEntry>& entries)
+    {
+        std::ifstream file{path};
+        std::string line;
+        while (std::getline(file, line)) {
+            std::string copy = line;   // tokenise took its line by value
+            std::vector<std::string> tokens = CSVReader::tokenise(copy, ',');
+            if (tokens.size() != 5) {
+                continue;
+            }
+            entries.push_back(legacyStringsToOBE(tokens[3], tokens[4], tokens[0], tokens[1], tokens[2]));
+        }
+        return entries.size();
+    }
+
+    bool report(const char* name, bool ok, const std::string& detail)
+    {
+        std::cout << (ok ? "ok    " : "FAIL  ") << name << ": " << detail << "\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    OrderFlowConfig config;
+    config.timestamps = 2000;
+    config.ordersPerTimestamp = 100;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--rows" && i + 1 < argc) {
+            size_t wanted = std::strtoull(argv[++i], nullptr, 10);
+            config.timestamps = std::max<size_t>(1, wanted / config.ordersPerTimestamp);
+        } else {
+            std::cerr << "usage: exchange_alloc_check [--rows N]\n";
+            return 2;
+        }
+    }
+    Logger::shared().setLevel(LogLevel::error);
+
+    // 1) Input: a generated CSV in the temp directory
+    fs::path path = fs::temp_directory_path() / "merkel_alloc_check.csv";
+    size_t rows;
+    {
+        std::ofstream out{path, std::ios::binary};
+        OrderFlowGenerator generator{config};
+        rows = generator.writeCSV(out);
+    }
+    bool ok = true;
+
+    // 2) readCSV against the old per-field copies; the old pass runs first, so both see
+    //    the timestamps and products already pooled
+    std::vector<OrderBookEntry> legacy;
+    size_t before = allocated();
+    legacyRead(path.string(), legacy);
+    double legacyPerRow = double(allocated() - before) / rows;
+
+    before = allocated();
+    std::vector<OrderBookEntry> entries = CSVReader::readCSV(path.string());
+    double perRow = double(allocated() - before) / rows;
+
+    ok &= report("readCSV rows", entries.size() == rows && legacy.size() == rows,
+                 std::to_string(entries.size()) + " of " + std::to_string(rows));
+    ok &= report("readCSV", perRow < 0.1 && perRow * 10 < legacyPerRow,
+                 std::to_string(perRow) + " allocations/row (per-field copies: " +
+                 std::to_string(legacyPerRow) + ")");
+
+    // 3) Per-order conversion and wallet check on pooled strings
+    const OrderBookEntry& sample = entries.front();
+    std::string price = std::to_string(sample.price), amount = std::to_string(sample.amount);
+    std::string timestamp{sample.timestamp}, product{sample.product};
+    Wallet wallet;
+    wallet.insertCurrency("BTC", 10);
+    wallet.canFulfillOrder(sample);   // first sight of the product fills the wallet's cache
+
+    const size_t repeats = 10000;
+    size_t pooled = 0, fulfilled = 0;
+    before = allocated();
+    for (size_t i = 0; i < repeats; ++i) {
+        OrderBookEntry obe = CSVReader::stringsToOBE(price, amount, timestamp, product, sample.orderType);
+        pooled += obe.timestamp.data() == sample.timestamp.data();
+    }
+    size_t convertAllocs = allocated() - before;
+    ok &= report("stringsToOBE", convertAllocs == 0 && pooled == repeats,
+                 std::to_string(convertAllocs) + " allocations in " + std::to_string(repeats) + " calls");
+
+    before = allocated();
+    for (size_t i = 0; i < repeats; ++i) {
+        fulfilled += wallet.canFulfillOrder(sample);
+    }
+    size_t walletAllocs = allocated() - before;
+    ok &= report("canFulfillOrder", walletAllocs == 0,
+                 std::to_string(walletAllocs) + " allocations in " + std::to_string(repeats) +
+                 " calls (" + std::to_string(fulfilled) + " fulfillable)");
+
+    // 4) Matching into a warm arena: the first pass sizes it, the second must not allocate
+    OrderBook book{std::vector<std::string>{path.string()}};
+    const std::vector<std::string> products = book.getKnownProducts();
+    const std::vector<std::string> times = book.getAllTimestamps();
+    OrderArena arena;
+    auto matchAll = [&] {
+        size_t sales = 0;
+        for (const auto& time : times) {
+            arena.reset();
+            for (const auto& p : products) {
+                sales += book.matchAsksToBids(p, time, arena).size();
+            }
+        }
+        return sales;
+    };
+    size_t warmSales = matchAll();
+    size_t arenaBefore = arena.allocationCount();
+    before = allocated();
+    size_t sales = matchAll();
+    size_t matchAllocs = allocated() - before;
+    size_t arenaAllocs = arena.allocationCount() - arenaBefore;
+    ok &= report("matchAsksToBids", matchAllocs == 0 && arenaAllocs == 0 && sales == warmSales && sales > 0,
+                 std::to_string(matchAllocs) + " allocations (arena: " + std::to_string(arenaAllocs) +
+                 ") over " + std::to_string(times.size()) + " timestamps, " + std::to_string(sales) + " sales");
+
+    std::error_code ec;
+    fs::remove(path, ec);
+    return ok ? 0 : 1;
+}
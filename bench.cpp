@@ -0,0 +1,291 @@
+#include "Benchmark.h"
+#include "CSVReader.h"
+#include "Logger.h"
+#include "OrderArena.h"
+#include "OrderBook.h"
+#include "OrderFlowGenerator.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#ifdef MERKEL_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/**
+ * exchange_bench: times the OrderBook hot paths on each input and writes the results as JSON.
+ *
+ * Usage:
+ *   exchange_bench [--filter TEXT] [--min-time SECONDS] [--rows N] [--out FILE] [--data DIR]
+ *
+ * Inputs (each benchmark is named "<operation>/<input>"):
+ *   small      20200317.csv
+ *   june       compressed_data.csv.gz, inflated once to a temp file (needs zlib)
+ *   synthetic  N generated rows (default 10,000,000), written once to a temp file
+ *
+ * Operations: readCSV, construct, getOrders, getCandlestickData, getVolumeData,
+ * getMeanPriceData, matchTimestep (matchAsksToBids for every product at one
+ * timestamp) and insertOrder. The JSON (Google Benchmark layout) goes to --out, or
+ * stdout if none is given; the progress table goes to stderr.
+ */
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    /** One benchmark input: a CSV path, built on first use, and the book parsed from it. */
+    struct Input
+    {
+        std::string name;
+        std::function<std::string()> prepare;   // returns the CSV path, or "" with `problem` set
+        std::string path;
+        std::string problem;
+        bool prepared = false;
+        std::unique_ptr<OrderBook> book;
+        std::vector<std::string> products;
+        std::vector<std::string> timestamps;
+
+        /** The CSV path, preparing it on first call; "" if the input is unavailable. */
+        const std::string& csv()
+        {
+            if (!prepared) {
+                prepared = true;
+                path = prepare();
+            }
+            return path;
+        }
+
+        /** The book loaded from csv(), built once and shared by the query benchmarks. */
+        OrderBook* orderBook()
+        {
+            if (!book && !csv().empty()) {
+                book = std::make_unique<OrderBook>(std::vector<std::string>{path});
+                products = book->getKnownProducts();
+                timestamps = book->getAllTimestamps();
+            }
+            return book.get();
+        }
+    };
+
+    /** Inflate a .gz file into the temp directory once; "" (with `problem`) if impossible. */
+    std::string inflateToTemp(const std::string& gzPath, std::string& problem)
+    {
+#ifdef MERKEL_HAVE_ZLIB
+        fs::path out = fs::temp_directory_path() / "merkel_bench_compressed_data.csv";
+        if (fs::exists(out)) {
+            return out.string();
+        }
+        gzFile in = gzopen(gzPath.c_str(), "rb");
+        if (!in) {
+            problem = "could not open " + gzPath;
+            return "";
+        }
+        std::ofstream file{out, std::ios::binary};
+        std::vector<char> buffer(1 << 20);
+        int n;
+        while ((n = gzread(in, buffer.data(), static_cast<unsigned>(buffer.size()))) > 0) {
+            file.write(buffer.data(), n);
+        }
+        gzclose(in);
+        if (n < 0 || !file) {
+            file.close();
+            fs::remove(out);
+            problem = "could not inflate " + gzPath;
+            return "";
+        }
+        return out.string();
+#else
+        (void)gzPath;
+        problem = "built without zlib";
+        return "";
+#endif
+    }
+
+    /**
+     * Write `rows` rows of generated order flow (OrderFlowGenerator defaults: 5 products,
+     * 100 orders per timestamp, fixed seed) to the temp directory, once per row count.
+     */
+    std::string writeSynthetic(size_t rows)
+    {
+        fs::path out = fs::temp_directory_path() /
+                       ("merkel_bench_synthetic_" + std::to_string(rows) + ".csv");
+        if (fs::exists(out)) {
+            return out.string();
+        }
+        OrderFlowConfig config;
+        config.timestamps = (rows + config.ordersPerTimestamp - 1) / config.ordersPerTimestamp;
+        std::ofstream file{out, std::ios::binary};
+        OrderFlowGenerator{config}.writeCSV(file);
+        return out.string();
+    }
+
+    /** Register every operation for one input. */
+    void addBenchmarks(BenchmarkRegistry& registry, Input& input)
+    {
+        const std::string suffix = "/" + input.name;
+
+        registry.add("readCSV" + suffix, [&input](BenchmarkState& state) {
+            if (input.csv().empty()) { state.skip(input.problem); return; }
+            size_t rows = 0;
+            while (state.keepRunning()) {
+                auto entries = CSVReader::readCSV(input.csv());
+                rows = entries.size();
+                doNotOptimize(entries.data());
+            }
+            state.setItemsProcessed(rows * state.iterations());
+            state.setBytesProcessed(fs::file_size(input.csv()) * state.iterations());
+            state.setCounter("rows", static_cast<double>(rows));
+        });
+
+        registry.add("construct" + suffix, [&input](BenchmarkState& state) {
+            if (input.csv().empty()) { state.skip(input.problem); return; }
+            while (state.keepRunning()) {
+                OrderBook book{std::vector<std::string>{input.csv()}};
+                doNotOptimize(book);
+            }
+            state.setBytesProcessed(fs::file_size(input.csv()) * state.iterations());
+        });
+
+        registry.add("getOrders" + suffix, [&input](BenchmarkState& state) {
+            OrderBook* book = input.orderBook();
+            if (!book) { state.skip(input.problem); return; }
+            size_t i = 0, found = 0;
+            while (state.keepRunning()) {
+                const auto& ts = input.timestamps[i % input.timestamps.size()];
+                const auto& product = input.products[i % input.products.size()];
+                auto orders = book->getOrders(OrderBookType::ask, product, ts);
+                found += orders.size();
+                ++i;
+            }
+            state.setItemsProcessed(found);
+        });
+
+        registry.add("getCandlestickData" + suffix, [&input](BenchmarkState& state) {
+            OrderBook* book = input.orderBook();
+            if (!book) { state.skip(input.problem); return; }
+            size_t candles = 0;
+            while (state.keepRunning()) {
+                auto data = book->getCandlestickData(OrderBookType::ask, input.products.front());
+                candles = data.size();
+                doNotOptimize(data.data());
+            }
+            state.setCounter("candles", static_cast<double>(candles));
+        });
+
+        registry.add("getVolumeData" + suffix, [&input](BenchmarkState& state) {
+            OrderBook* book = input.orderBook();
+            if (!book) { state.skip(input.problem); return; }
+            while (state.keepRunning()) {
+                auto data = book->getVolumeData(OrderBookType::ask, input.products.front());
+                doNotOptimize(data.data());
+            }
+        });
+
+        registry.add("getMeanPriceData" + suffix, [&input](BenchmarkState& state) {
+            OrderBook* book = input.orderBook();
+            if (!book) { state.skip(input.problem); return; }
+            while (state.keepRunning()) {
+                auto data = book->getMeanPriceData(OrderBookType::ask, input.products.front());
+                doNotOptimize(data.data());
+            }
+        });
+
+        registry.add("matchTimestep" + suffix, [&input](BenchmarkState& state) {
+            OrderBook* book = input.orderBook();
+            if (!book) { state.skip(input.problem); return; }
+            OrderArena arena;
+            size_t i = 0, sales = 0;
+            while (state.keepRunning()) {
+                const auto& ts = input.timestamps[i++ % input.timestamps.size()];
+                arena.reset();
+                for (auto const& p : input.products) {
+                    sales += book->matchAsksToBids(p, ts, arena).size();
+                }
+            }
+            state.setItemsProcessed(sales);
+        });
+
+        // Last for this input: it grows the shared book's user partition
+        registry.add("insertOrder" + suffix, [&input](BenchmarkState& state) {
+            OrderBook* book = input.orderBook();
+            if (!book) { state.skip(input.problem); return; }
+            size_t i = 0;
+            while (state.keepRunning()) {
+                const auto& ts = input.timestamps[(i * 7919) % input.timestamps.size()];
+                book->insertOrder(OrderBookEntry{1.0, 1.0, ts, input.products.front(),
+                                                 OrderBookType::bid, "simuser"});
+                ++i;
+            }
+            state.setItemsProcessed(state.iterations());
+        });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filter, outFile, dataDir = ".";
+    double minSeconds = 0.5;
+    size_t syntheticRows = 10000000;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else if (arg == "--min-time" && hasValue) {
+            minSeconds = std::atof(argv[++i]);
+        } else if (arg == "--rows" && hasValue) {
+            syntheticRows = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--out" && hasValue) {
+            outFile = argv[++i];
+        } else if (arg == "--data" && hasValue) {
+            dataDir = argv[++i];
+        } else {
+            std::cerr << "usage: exchange_bench [--filter TEXT] [--min-time SECONDS] [--rows N] "
+                         "[--out FILE] [--data DIR]\n";
+            return 2;
+        }
+    }
+
+    // Keep the engine's log lines (e.g. the bad rows in the shipped data) out of the timings
+    Logger::shared().setLevel(LogLevel::error);
+
+    std::vector<std::unique_ptr<Input>> inputs;
+    auto addInput = [&](std::string name, std::function<std::string(Input&)> prepare) {
+        auto input = std::make_unique<Input>();
+        input->name = std::move(name);
+        Input* self = input.get();
+        input->prepare = [self, prepare] { return prepare(*self); };
+        inputs.push_back(std::move(input));
+    };
+    addInput("small", [dataDir](Input& in) {
+        std::string path = (fs::path(dataDir) / "20200317.csv").string();
+        if (!fs::exists(path)) { in.problem = "missing " + path; return std::string(); }
+        return path;
+    });
+    addInput("june", [dataDir](Input& in) {
+        std::string path = (fs::path(dataDir) / "compressed_data.csv.gz").string();
+        if (!fs::exists(path)) { in.problem = "missing " + path; return std::string(); }
+        return inflateToTemp(path, in.problem);
+    });
+    addInput("synthetic", [syntheticRows](Input&) {
+        return writeSynthetic(syntheticRows);
+    });
+
+    BenchmarkRegistry registry;
+    for (auto& input : inputs) {
+        addBenchmarks(registry, *input);
+    }
+    registry.run(filter, minSeconds, std::cerr);
+
+    if (outFile.empty()) {
+        registry.writeJson(std::cout);
+    } else {
+        std::ofstream out{outFile};
+        registry.writeJson(out);
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <QApplication>
+#include "ChartWidget.h"
+#include "OrderBook.h"
+#include "Wallet.h"
+#include "Simulation.h"
+#include "Logger.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+/**
+ * exchange_chart: renders ChartWidget to a PNG without a display.
+ *
+ * Usage:
+ *   exchange_chart [--bid] [--steps N] [--size WxH] <data> <product> [out.png]
+ *
+ *   --steps N   feed the widget N simulation timesteps, one appendTimestamp() each
+ *               (the way the interactive program does); without it the widget is
+ *               loaded with the whole book through loadAll()
+ *   out.png     defaults to chart.png
+ *
+ * Uses Qt's "offscreen" platform unless QT_QPA_PLATFORM is already set, so it
+ * runs the same on a headless machine as on a desktop.
+ */
+int main(int argc, char* argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    OrderBookType side = OrderBookType::ask;
+    size_t steps = 0;
+    int width = 900, height = 600;
+    std::string data, product, out = "chart.png";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bid") {
+            side = OrderBookType::bid;
+        } else if (arg == "--steps" && i + 1 < argc) {
+            steps = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--size" && i + 1 < argc) {
+            std::string size = argv[++i];
+            auto x = size.find('x');
+            if (x != std::string::npos) {
+                width  = std::atoi(size.substr(0, x).c_str());
+                height = std::atoi(size.substr(x + 1).c_str());
+            }
+        } else if (data.empty()) {
+            data = arg;
+        } else if (product.empty()) {
+            product = arg;
+        } else {
+            out = arg;
+        }
+    }
+    if (data.empty() || product.empty()) {
+        std::cerr << "usage: exchange_chart [--bid] [--steps N] [--size WxH] <data> <product> [out.png]\n";
+        return 2;
+    }
+    Logger::shared().setLevel(LogLevel::warn);
+
+    OrderBook orderBook = OrderBook::fromGlob(data);
+    ChartWidget chart(orderBook, product, side);
+    chart.resize(width, height);
+
+    if (steps == 0) {
+        chart.loadAll();
+    } else {
+        Wallet wallet;
+        Simulation sim(orderBook, wallet);
+        for (size_t i = 0; i < steps; ++i) {
+            auto result = sim.step();
+            chart.appendTimestamp(result.timestamp);
+            if (result.wrapped) {
+                break;
+            }
+        }
+    }
+
+    if (!chart.grab().save(QString::fromStdString(out))) {
+        std::cerr << "exchange_chart: could not write " << out << "\n";
+        return 1;
+    }
+    Logger::shared().flush();
+    std::cout << out << ": " << chart.candleCount() << " candles, "
+              << chart.volumeCount() << " volume points, "
+              << chart.minuteCount() << " minutes\n";
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "OrderFlowGenerator.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/**
+ * exchange_gen: writes a synthetic, seed-reproducible order book CSV.
+ *
+ * Usage:
+ *   exchange_gen [--seed N] [--products N] [--timestamps N] [--orders N]
+ *                [--volatility X] [--spread X] [--crossing X] [--out FILE]
+ *
+ *   --orders      orders per timestamp (rows = timestamps * orders)
+ *   --volatility  std. dev. of each product's relative mid move per timestamp
+ *   --spread      how far (as a fraction of the mid) orders sit from the mid
+ *   --crossing    fraction of orders priced through the mid, so bids and asks trade
+ *   --out         output file (default: stdout)
+ *
+ * The same options and seed always produce the same file.
+ */
+int main(int argc, char* argv[])
+{
+    OrderFlowConfig config;
+    std::string outFile;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            arg.clear();   // every option takes a value
+        }
+        if (arg == "--seed") {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--products") {
+            config.products = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--timestamps") {
+            config.timestamps = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--orders") {
+            config.ordersPerTimestamp = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--volatility") {
+            config.volatility = std::atof(argv[++i]);
+        } else if (arg == "--spread") {
+            config.spread = std::atof(argv[++i]);
+        } else if (arg == "--crossing") {
+            config.crossingRate = std::atof(argv[++i]);
+        } else if (arg == "--out") {
+            outFile = argv[++i];
+        } else {
+            std::cerr << "usage: exchange_gen [--seed N] [--products N] [--timestamps N] [--orders N]\n"
+                         "                    [--volatility X] [--spread X] [--crossing X] [--out FILE]\n";
+            return 2;
+        }
+    }
+
+    OrderFlowGenerator generator{config};
+    size_t rows;
+    if (outFile.empty()) {
+        rows = generator.writeCSV(std::cout);
+    } else {
+        std::ofstream out{outFile, std::ios::binary};
+        if (!out.is_open()) {
+            std::cerr << "exchange_gen: could not open " << outFile << "\n";
+            return 1;
+        }
+        rows = generator.writeCSV(out);
+    }
+    std::cerr << "exchange_gen: wrote " << rows << " rows\n";
+    return 0;
+}
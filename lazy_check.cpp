@@ -0,0 +1,125 @@
+#include "Logger.h"
+#include "OrderBook.h"
+#include "OrderFlowGenerator.h"
+#include "Simulation.h"
+#include "Wallet.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * exchange_lazy_check: checks that a lazily loaded book answers like an eagerly loaded one,
+ * including on a file whose rows are out of time order; fails (exit code 1) if not.
+ *
+ * Usage:
+ *   exchange_lazy_check [--rows N]
+ *
+ * Inputs: a generated CSV in time order, and the same rows rotated by half so the file
+ * starts and ends mid-range. For each, the two books must report the same earliest
+ * timestamp, the same distinct timestamps, and the same timesteps and sales when the
+ * simulation runs to the end.
+ */
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    /** What one run over a book produced. */
+    struct Outcome
+    {
+        std::string earliest;
+        std::vector<std::string> timestamps;
+        size_t timesteps = 0;
+        size_t sales = 0;
+    };
+
+    Outcome run(const std::string& path, LoadMode mode)
+    {
+        OrderBook book{std::vector<std::string>{path}, mode};
+        Outcome outcome;
+        outcome.earliest = book.getEarliestTime();
+
+        // Simulate first: getAllTimestamps parses every partition, which would hide a
+        // wrong range on the lazy side
+        Wallet wallet;
+        Simulation sim(book, wallet);
+        sim.runToEnd();
+        outcome.timesteps = sim.stats().timesteps;
+        outcome.sales = sim.stats().sales;
+
+        outcome.timestamps = book.getAllTimestamps();
+        return outcome;
+    }
+
+    std::string describe(const Outcome& o)
+    {
+        return "from " + o.earliest + ", " + std::to_string(o.timestamps.size()) + " timestamps, " +
+               std::to_string(o.timesteps) + " timesteps, " + std::to_string(o.sales) + " sales";
+    }
+
+    bool check(const char* name, const std::string& path)
+    {
+        Outcome eager = run(path, LoadMode::eager);
+        Outcome lazy  = run(path, LoadMode::lazy);
+        bool ok = eager.earliest == lazy.earliest && eager.timestamps == lazy.timestamps &&
+                  eager.timesteps == lazy.timesteps && eager.sales == lazy.sales;
+        std::cout << (ok ? "ok    " : "FAIL  ") << name << ": eager " << describe(eager)
+                  << "; lazy " << describe(lazy) << "\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    OrderFlowConfig config;
+    config.timestamps = 200;
+    config.ordersPerTimestamp = 50;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--rows" && i + 1 < argc) {
+            size_t wanted = std::strtoull(argv[++i], nullptr, 10);
+            config.timestamps = std::max<size_t>(2, wanted / config.ordersPerTimestamp);
+        } else {
+            std::cerr << "usage: exchange_lazy_check [--rows N]\n";
+            return 2;
+        }
+    }
+    Logger::shared().setLevel(LogLevel::error);
+
+    // 1) Inputs: the generated rows as written, and rotated by half
+    std::ostringstream csv;
+    OrderFlowGenerator{config}.writeCSV(csv);
+    std::vector<std::string> rows;
+    std::istringstream in{csv.str()};
+    for (std::string line; std::getline(in, line); ) {
+        rows.push_back(line);
+    }
+    std::rotate(rows.begin(), rows.begin() + static_cast<long>(rows.size() / 2), rows.end());
+
+    fs::path sorted   = fs::temp_directory_path() / "merkel_lazy_check_sorted.csv";
+    fs::path unsorted = fs::temp_directory_path() / "merkel_lazy_check_unsorted.csv";
+    {
+        std::ofstream out{sorted, std::ios::binary};
+        out << csv.str();
+    }
+    {
+        std::ofstream out{unsorted, std::ios::binary};
+        for (const auto& row : rows) {
+            out << row << '\n';
+        }
+    }
+
+    // 2) Lazy against eager on each
+    bool ok = true;
+    ok &= check("sorted file", sorted.string());
+    ok &= check("unsorted file", unsorted.string());
+
+    std::error_code ec;
+    fs::remove(sorted, ec);
+    fs::remove(unsorted, ec);
+    return ok ? 0 : 1;
+}
@@ -10,7 +10,10 @@ int main(int argc, char* argv[])
     QApplication app(argc, argv);
 
     // ── 1) Load your data ───────────────────────
-    OrderBook orderBook("20200317.csv", "20200601.csv");
+    //    (optionally: a directory or glob of daily files, e.g. "data/2020*.csv")
+    OrderBook orderBook = (argc > 1)
+        ? OrderBook::fromGlob(argv[1])
+        : OrderBook("20200317.csv", "20200601.csv");
     Wallet    wallet;
     wallet.insertCurrency("BTC", 10);
 
@@ -38,6 +41,8 @@ int main(int argc, char* argv[])
         int choice = cli.getUserOption();
         if (choice == 0) break;           // 0 = Quit
         cli.processUserOption(choice);
+        // Let the chart window (if open) repaint between commands
+        QApplication::processEvents();
     }
 
     return 0;
@@ -0,0 +1,227 @@
+#include "OrderBook.h"
+#include "Wallet.h"
+#include "WalletManager.h"
+#include "CurrencyRegistry.h"
+#include "StringPool.h"
+#include "Simulation.h"
+#include "CSVReader.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/**
+ * exchange_replay: runs the simulation headless, at full speed, and prints summary stats.
+ *
+ * Usage:
+ *   exchange_replay [--lazy] [--budget MB] [--quiet|--verbose] <data> [script|-]
+ *
+ *   <data>   a CSV file, a directory of CSVs, or a glob such as "data/2020*.csv"
+ *   script   one action per line ("-" reads stdin); without one the book is run to the end:
+ *              deposit <CURRENCY> <amount>        add funds to the wallet
+ *              ask <PRODUCT> <price> <amount>     queue an ask for the next step
+ *              bid <PRODUCT> <price> <amount>     queue a bid for the next step
+ *              account <NAME> <CURRENCY> <amount> open (or top up) a simulated trader's account
+ *              trade <NAME> ask|bid <PRODUCT> <price> <amount>
+ *                                                 queue that trader's order for the next step
+ *              step [n]                           match and advance n ≥ 1 timesteps (default 1)
+ *              run                                step until the last timestamp is matched
+ *              wallet                             print the wallet
+ *            blank lines and lines starting with '#' are ignored.
+ *
+ * The wallet starts with 10 BTC, like the interactive program. Library log lines go
+ * through the buffered Logger (warn level by default), so the replay itself does no
+ * synchronous console I/O until the summary.
+ */
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double msSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    /** Run one script line against `sim`; false (with a message) if it is malformed. */
+    bool runAction(const std::string& line, Simulation& sim, Wallet& wallet, WalletManager& accounts)
+    {
+        std::istringstream in{line};
+        std::string action;
+        in >> action;
+
+        if (action == "deposit") {
+            std::string currency;
+            double amount;
+            if (!(in >> currency >> amount) || amount < 0) {
+                return false;
+            }
+            wallet.insertCurrency(currency, amount);
+            return true;
+        }
+        if (action == "ask" || action == "bid") {
+            std::string product, price, amount;
+            if (!(in >> product >> price >> amount)) {
+                return false;
+            }
+            try {
+                auto obe = CSVReader::stringsToOBE(
+                    price, amount, sim.currentTime(), product,
+                    action == "ask" ? OrderBookType::ask : OrderBookType::bid);
+                // Queued like any other producer's order; entered (or rejected, which is
+                // counted in the stats) by the next step
+                return sim.submitOrder(obe);
+            } catch (...) {
+                return false;
+            }
+        }
+        if (action == "account") {
+            std::string name, currency;
+            double amount;
+            if (!(in >> name >> currency >> amount) || amount < 0) {
+                return false;
+            }
+            accounts.deposit(accounts.openAccount(name), CurrencyRegistry::shared().idOf(currency), amount);
+            return true;
+        }
+        if (action == "trade") {
+            std::string name, side, product, price, amount;
+            if (!(in >> name >> side >> product >> price >> amount) || (side != "ask" && side != "bid")) {
+                return false;
+            }
+            try {
+                // Named after the trader, so the step checks and settles it against
+                // that trader's account instead of the wallet
+                auto obe = CSVReader::stringsToOBE(
+                    price, amount, sim.currentTime(), product,
+                    side == "ask" ? OrderBookType::ask : OrderBookType::bid);
+                obe.username = StringPool::shared().intern(name);
+                return sim.submitOrder(obe);
+            } catch (...) {
+                return false;
+            }
+        }
+        if (action == "step") {
+            long long n = 1;
+            // The count is optional, but one that is given must be a positive number
+            if (!(in >> std::ws).eof() && (!(in >> n) || n <= 0)) {
+                return false;
+            }
+            for (long long i = 0; i < n; ++i) {
+                sim.step();
+            }
+            return true;
+        }
+        if (action == "run") {
+            sim.runToEnd();
+            return true;
+        }
+        if (action == "wallet") {
+            std::cout << wallet.toString();
+            return true;
+        }
+        return false;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    LoadMode mode = LoadMode::eager;
+    size_t budget = 0;
+    LogLevel logLevel = LogLevel::warn;
+    std::string data, script;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lazy") {
+            mode = LoadMode::lazy;
+        } else if (arg == "--budget" && i + 1 < argc) {
+            budget = std::strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+        } else if (arg == "--quiet") {
+            logLevel = LogLevel::error;
+        } else if (arg == "--verbose") {
+            logLevel = LogLevel::info;
+        } else if (data.empty()) {
+            data = arg;
+        } else {
+            script = arg;
+        }
+    }
+    if (data.empty()) {
+        std::cerr << "usage: exchange_replay [--lazy] [--budget MB] [--quiet|--verbose] <data> [script|-]\n";
+        return 2;
+    }
+    Logger::shared().setLevel(logLevel);
+
+    // 1) Load the book
+    auto loadStart = Clock::now();
+    OrderBook orderBook = OrderBook::fromGlob(data, mode, budget);
+    double loadMs = msSince(loadStart);
+
+    Wallet wallet;
+    wallet.insertCurrency("BTC", 10);
+    Simulation sim(orderBook, wallet);
+    WalletManager accounts;
+    sim.attachAccounts(accounts);
+
+    // 2) Run the script, or the whole book
+    auto runStart = Clock::now();
+    size_t lineNo = 0, errors = 0;
+    if (script.empty()) {
+        sim.runToEnd();
+    } else {
+        std::ifstream file;
+        if (script != "-") {
+            file.open(script);
+            if (!file.is_open()) {
+                std::cerr << "exchange_replay: could not open script " << script << "\n";
+                return 1;
+            }
+        }
+        std::istream& in = (script == "-") ? std::cin : file;
+        std::string line;
+        while (std::getline(in, line)) {
+            ++lineNo;
+            auto start = line.find_first_not_of(" \t\r");
+            if (start == std::string::npos || line[start] == '#') {
+                continue;
+            }
+            if (!runAction(line, sim, wallet, accounts)) {
+                ++errors;
+                LOG_ERROR("exchange_replay: bad script line " << lineNo << ": " << line);
+            }
+        }
+    }
+    double runMs = msSince(runStart);
+    Logger::shared().flush();
+
+    // 3) Summary
+    const auto& st = sim.stats();
+    double seconds = runMs / 1000.0;
+    std::ostringstream out;
+    out << "files:            " << orderBook.getLoadedFiles().size() << "\n"
+        << "load ms:          " << loadMs << "\n"
+        << "run ms:           " << runMs << "\n"
+        << "timesteps:        " << st.timesteps << "\n"
+        << "sales:            " << st.sales << "\n"
+        << "volume:           " << st.volume << "\n"
+        << "orders placed:    " << st.ordersPlaced << "\n"
+        << "orders rejected:  " << st.ordersRejected << "\n"
+        << "user fills:       " << st.userFills << "\n"
+        << "accounts:         " << accounts.accountCount() << "\n"
+        << "account fills:    " << st.accountFills << "\n"
+        << "script errors:    " << errors << "\n"
+        << "timesteps/s:      " << (seconds > 0 ? st.timesteps / seconds : 0.0) << "\n"
+        << "sales/s:          " << (seconds > 0 ? st.sales / seconds : 0.0) << "\n"
+        << "resident bytes:   " << orderBook.getResidentBytes() << "\n"
+        << "wallet:\n" << wallet.toString();
+    if (Metrics::enabled()) {
+        out << "instrumentation:\n" << Metrics::report();
+    }
+    std::cout << out.str();
+    return errors == 0 ? 0 : 1;
+}